@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    BenchmarkRunner.cpp
+
+  ==============================================================================
+*/
+
+#include "BenchmarkRunner.h"
+
+#include <iostream>
+
+void BenchmarkRunner::add(const juce::String& name, Body body)
+{
+    cases.push_back({ name, std::move(body) });
+}
+
+juce::Array<BenchmarkRunner::Result> BenchmarkRunner::run(const Options& options)
+{
+    juce::Array<Result> results;
+    currentOptions = options;
+
+    for (auto& benchmarkCase : cases)
+    {
+        if (options.filter.isNotEmpty() && ! benchmarkCase.name.contains(options.filter))
+            continue;
+
+        currentResult = {};
+        currentResult.name = benchmarkCase.name;
+
+        benchmarkCase.body(*this);
+
+        // Every body must end up calling measure().
+        jassert(currentResult.iterations > 0);
+
+        std::cout << benchmarkCase.name.paddedRight(' ', 64)
+                  << juce::String(currentResult.nsPerIteration, 1).paddedLeft(' ', 14) << " ns/iter";
+
+        if (currentResult.nsPerSample > 0.0)
+            std::cout << juce::String(currentResult.nsPerSample, 3).paddedLeft(' ', 12) << " ns/sample"
+                      << juce::String(currentResult.realtimeFactor, 1).paddedLeft(' ', 12) << "x realtime";
+
+        std::cout << std::endl;
+
+        results.add(currentResult);
+    }
+
+    return results;
+}
+
+juce::var BenchmarkRunner::toJson(const juce::Array<Result>& results)
+{
+    auto* context = new juce::DynamicObject();
+    context->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    context->setProperty("cpu", juce::SystemStats::getCpuModel());
+    context->setProperty("num_cpus", juce::SystemStats::getNumCpus());
+    context->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    context->setProperty("juce_version", juce::SystemStats::getJUCEVersion());
+    context->setProperty("simd_lanes_float", static_cast<int>(juce::dsp::SIMDRegister<float>::size()));
+
+    juce::Array<juce::var> benchmarks;
+
+    for (const auto& result : results)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("name", result.name);
+        object->setProperty("iterations", result.iterations);
+        object->setProperty("ns_per_iteration", result.nsPerIteration);
+        object->setProperty("ns_per_sample", result.nsPerSample);
+        object->setProperty("realtime_factor", result.realtimeFactor);
+        benchmarks.add(juce::var(object));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("context", juce::var(context));
+    root->setProperty("benchmarks", benchmarks);
+
+    return juce::var(root);
+}
+
+int BenchmarkRunner::compareWithBaseline(const juce::Array<Result>& results, const juce::var& baseline, double maxRegressionPercent)
+{
+    int numRegressions = 0;
+    auto* baselineBenchmarks = baseline["benchmarks"].getArray();
+
+    if (baselineBenchmarks == nullptr)
+    {
+        std::cerr << "The baseline file has no \"benchmarks\" array" << std::endl;
+        return 1;
+    }
+
+    for (const auto& result : results)
+    {
+        for (const auto& previous : *baselineBenchmarks)
+        {
+            if (previous["name"].toString() != result.name)
+                continue;
+
+            const auto before = static_cast<double>(previous["ns_per_iteration"]);
+
+            if (before <= 0.0)
+                break;
+
+            const auto changePercent = (result.nsPerIteration - before) * 100.0 / before;
+
+            if (changePercent > maxRegressionPercent)
+            {
+                ++numRegressions;
+                std::cout << "REGRESSION " << result.name << ": " << juce::String(before, 1) << " -> "
+                          << juce::String(result.nsPerIteration, 1) << " ns/iter (+" << juce::String(changePercent, 1) << "%)" << std::endl;
+            }
+
+            break;
+        }
+    }
+
+    return numRegressions;
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    BenchmarkRunner.h
+
+    A small Google Benchmark style harness: named cases, automatic iteration
+    counts, repeated measurements, JSON output and a regression gate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class BenchmarkRunner
+{
+public:
+    struct Options
+    {
+        // Only cases whose names contain this are run.
+        juce::String filter;
+
+        // Each repetition runs for at least this long, and the median repetition is reported.
+        double minSecondsPerRepetition { 0.1 };
+        int repetitions { 5 };
+    };
+
+    struct Result
+    {
+        juce::String name;
+        juce::int64 iterations { 0 };
+        double nsPerIteration { 0.0 };
+
+        // Per sample frame (one sample on every channel); only filled in for cases that process audio.
+        double nsPerSample { 0.0 };
+
+        // Seconds of audio processed per second of CPU time.
+        double realtimeFactor { 0.0 };
+    };
+
+    using Body = std::function<void(BenchmarkRunner&)>;
+
+    // Registers a case. The body does its own setup and then calls measure() exactly once.
+    void add(const juce::String& name, Body body);
+
+    /* Times an iteration function. samplesPerIteration and audioSecondsPerIteration describe how much audio one
+     * call processes, and can be 0 for cases that don't process audio. The iteration count is picked automatically.
+     */
+    template <typename IterationFunction>
+    void measure(double samplesPerIteration, double audioSecondsPerIteration, IterationFunction&& iteration);
+
+    // Runs every registered case that matches the filter, printing a line per case as it goes.
+    juce::Array<Result> run(const Options& options);
+
+    // Results as JSON, along with enough context about the machine to tell whether two files are comparable.
+    static juce::var toJson(const juce::Array<Result>& results);
+
+    /* Compares results with a previous JSON file, and prints every case whose time per iteration has grown by more
+     * than maxRegressionPercent. Returns the number of regressions found.
+     */
+    static int compareWithBaseline(const juce::Array<Result>& results, const juce::var& baseline, double maxRegressionPercent);
+
+private:
+    struct Case
+    {
+        juce::String name;
+        Body body;
+    };
+
+    std::vector<Case> cases;
+
+    // Filled in by measure() while a case is running.
+    Options currentOptions;
+    Result currentResult;
+};
+
+//==============================================================================
+template <typename IterationFunction>
+void BenchmarkRunner::measure(double samplesPerIteration, double audioSecondsPerIteration, IterationFunction&& iteration)
+{
+    auto secondsFor = [&iteration](juce::int64 numIterations)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (juce::int64 i = 0; i < numIterations; ++i)
+            iteration();
+
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    };
+
+    // Warm up, doubling the iteration count until a batch takes a measurable amount of time.
+    juce::int64 numIterations = 1;
+    auto elapsed = secondsFor(numIterations);
+
+    while (elapsed < currentOptions.minSecondsPerRepetition * 0.1 && numIterations < (juce::int64(1) << 40))
+    {
+        numIterations *= 2;
+        elapsed = secondsFor(numIterations);
+    }
+
+    // Scale the count so each repetition lasts about minSecondsPerRepetition.
+    const auto secondsPerIteration = juce::jmax(elapsed / static_cast<double>(numIterations), 1.0e-12);
+    numIterations = juce::jmax(juce::int64(1), static_cast<juce::int64>(currentOptions.minSecondsPerRepetition / secondsPerIteration));
+
+    std::vector<double> nsPerIteration;
+
+    for (int r = 0; r < juce::jmax(1, currentOptions.repetitions); ++r)
+        nsPerIteration.push_back(secondsFor(numIterations) * 1.0e9 / static_cast<double>(numIterations));
+
+    std::sort(nsPerIteration.begin(), nsPerIteration.end());
+    const auto median = nsPerIteration[nsPerIteration.size() / 2];
+
+    currentResult.iterations = numIterations;
+    currentResult.nsPerIteration = median;
+    currentResult.nsPerSample = samplesPerIteration > 0.0 ? median / samplesPerIteration : 0.0;
+    currentResult.realtimeFactor = audioSecondsPerIteration > 0.0 ? audioSecondsPerIteration * 1.0e9 / median : 0.0;
+}
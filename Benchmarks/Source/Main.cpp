@@ -0,0 +1,437 @@
+/*
+  ==============================================================================
+
+    BasicEQBenchmarks - DSP benchmarks for the BasicEQ processor.
+
+    Usage:
+        BasicEQBenchmarks [--filter <text>] [--full] [--json <results.json>]
+                          [--baseline <previous.json>] [--max-regression <percent>]
+                          [--min-time <seconds>] [--repetitions <n>]
+
+    By default every dimension is swept on its own around a typical setup (256 samples, 48 kHz, stereo,
+    12 dB/Oct cuts, static parameters, minimum phase, no oversampling), plus every slope combination, linear phase
+    at every sample rate, every oversampling setting, 0 to 24 active bands, 8 dynamic bands, float, mixed and
+    double precision, state variable filters, silent input, sample-accurate automation and every channel mode,
+    plus the cost of constructing and preparing an instance. --full runs the complete cross product.
+    With --baseline, the exit code is non-zero if any case got slower by more than --max-regression percent.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "BenchmarkRunner.h"
+
+#include <iostream>
+
+//==============================================================================
+struct ProcessCase
+{
+    int blockSize { 256 };
+    double sampleRate { 48000.0 };
+    int numChannels { 2 };
+    int lowCutSlope { 0 };
+    int highCutSlope { 0 };
+    bool automated { false };
+    bool linearPhase { false };
+
+    // "Oversampling" and "Oversampling Filter" choice indices. Cases run without oversampling unless they ask for it.
+    int oversampling { 0 };
+    int oversamplingFilter { 0 };
+
+    // How many bells have gain on them; the rest are flat, and should cost nothing.
+    int numActiveBands { 1 };
+
+    // How many of those bands are dynamic, with their detectors always over the threshold.
+    int numDynamicBands { 0 };
+
+    // 0 runs float buffers with "Precision" on float, 1 float buffers with it on mixed, and 2 double buffers.
+    int precision { 0 };
+
+    // Runs the chain as state variable filters rather than direct form II.
+    bool stateVariable { false };
+
+    // Feeds digital silence, long enough for the instance to notice and stop processing before it's timed.
+    bool silent { false };
+
+    /* With automation, how many points along each block's curve are also queued with addParameterChange(), so the
+     * block is split and redesigned at each one rather than taking the curve's end value for the whole block.
+     */
+    int breakpoints { 0 };
+
+    /* The "Channel Mode" choice index. Outside linked mode, active bands alternate between the first and second
+     * channel group, so both groups run different coefficients.
+     */
+    int channelMode { 0 };
+
+    juce::String getName() const
+    {
+        return "processBlock/block:" + juce::String(blockSize)
+             + "/rate:" + juce::String(juce::roundToInt(sampleRate))
+             + "/channels:" + juce::String(numChannels)
+             + "/slopes:" + juce::String(lowCutSlope) + "x" + juce::String(highCutSlope)
+             + (automated ? "/automated" : "/static")
+             + (linearPhase ? "/linear-phase" : "")
+             + (oversampling > 0 ? "/oversampling:" + juce::String(1 << oversampling) + "x"
+                                   + (oversamplingFilter > 0 ? "-fir" : "-iir") : "")
+             + (numActiveBands != 1 ? "/bands:" + juce::String(numActiveBands) : "")
+             + (numDynamicBands > 0 ? "/dynamic:" + juce::String(numDynamicBands) : "")
+             + (precision == 1 ? "/precision:mixed" : precision == 2 ? "/precision:double" : "")
+             + (stateVariable ? "/topology:svf" : "")
+             + (silent ? "/input:silent" : "")
+             + (breakpoints > 0 ? "/sample-accurate:" + juce::String(breakpoints) : "")
+             + (channelMode == 1 ? "/channel-mode:left-right" : channelMode == 2 ? "/channel-mode:mid-side"
+                                  : channelMode == 3 ? "/channel-mode:front-rear" : "");
+    }
+};
+
+// Sets a parameter from a real-world value, the same way a host would.
+static void setParameter(BasicEQAudioProcessor& processor, const juce::String& parameterID, float value)
+{
+    if (auto* parameter = processor.apvts.getParameter(parameterID))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+template <typename SampleType>
+static void measureProcessBlock(BenchmarkRunner& runner, BasicEQAudioProcessor& processor, const ProcessCase& setup)
+{
+    // Low level noise, so the filters never settle into denormals or exact zeros, unless the case asks for silence.
+    juce::AudioBuffer<SampleType> buffer(setup.numChannels, setup.blockSize);
+    juce::Random random(1);
+    buffer.clear();
+
+    if (! setup.silent)
+        for (int channel = 0; channel < setup.numChannels; ++channel)
+            for (int i = 0; i < setup.blockSize; ++i)
+                buffer.setSample(channel, i, static_cast<SampleType>((random.nextFloat() - 0.5f) * 0.1f));
+
+    juce::MidiBuffer midi;
+
+    // Silence is only skipped once the tail and latency have passed, which can be longer than the warm-up.
+    if (setup.silent)
+    {
+        const auto holdSamples = processor.getTailLengthSeconds() * setup.sampleRate + processor.getLatencySamples();
+
+        for (int i = 0; i <= juce::roundToInt(holdSamples) / setup.blockSize + 1; ++i)
+            processor.processBlock(buffer, midi);
+    }
+    int blockIndex = 0;
+    auto* frequencyParameter = processor.apvts.getParameter("Band 1 Freq");
+    auto* gainParameter = processor.apvts.getParameter("Band 1 Gain");
+
+    // Automation moves the first band on every block, as a host would when drawing a fast LFO-like curve.
+    auto processOneBlock = [&]
+    {
+        if (setup.automated)
+        {
+            const auto phase = static_cast<float>(blockIndex++ % 64) / 64.f;
+            setParameter(processor, "Band 1 Freq", 200.f + 4000.f * phase);
+            setParameter(processor, "Band 1 Gain", -12.f + 24.f * phase);
+            setParameter(processor, "Band 1 Quality", 0.5f + 4.f * phase);
+
+            // The points between the last block's value and this one's, evenly spaced, each at its own sample.
+            for (int point = 0; point < setup.breakpoints; ++point)
+            {
+                const auto offset = point * setup.blockSize / setup.breakpoints;
+                const auto pointPhase = phase - static_cast<float>(setup.breakpoints - point) / static_cast<float>(setup.breakpoints * 64);
+                const auto wrapped = pointPhase < 0.f ? pointPhase + 1.f : pointPhase;
+
+                for (auto* parameter : { frequencyParameter, gainParameter })
+                {
+                    const auto value = parameter == frequencyParameter ? 200.f + 4000.f * wrapped : -12.f + 24.f * wrapped;
+                    processor.addParameterChange(parameter->getParameterIndex(), offset, parameter->convertTo0to1(value));
+                }
+            }
+        }
+
+        processor.processBlock(buffer, midi);
+    };
+
+    runner.measure(static_cast<double>(setup.blockSize),
+                   static_cast<double>(setup.blockSize) / setup.sampleRate,
+                   processOneBlock);
+}
+
+static void benchmarkProcessBlock(BenchmarkRunner& runner, const ProcessCase& setup)
+{
+    BasicEQAudioProcessor processor;
+
+    setParameter(processor, "LowCut Freq", 80.f);
+    setParameter(processor, "HighCut Freq", 16000.f);
+    setParameter(processor, "Band Count", static_cast<float>(juce::jmax(minBands, setup.numActiveBands)));
+
+    for (int i = 0; i < setup.numActiveBands; ++i)
+        setParameter(processor, getBandParameterPrefix(i) + "Gain", 4.f);
+
+    setParameter(processor, "Channel Mode", static_cast<float>(setup.channelMode));
+
+    if (setup.channelMode > 0)
+        for (int i = 0; i < setup.numActiveBands; ++i)
+            setParameter(processor, getBandParameterPrefix(i) + "Channels", static_cast<float>(1 + i % 2));
+
+    for (int i = 0; i < juce::jmin(setup.numDynamicBands, maxDynamicBands); ++i)
+    {
+        setParameter(processor, getBandParameterPrefix(i) + "Dynamic", 1.f);
+        setParameter(processor, getBandParameterPrefix(i) + "Threshold", -60.f);
+    }
+
+    setParameter(processor, "LowCut Slope", static_cast<float>(setup.lowCutSlope));
+    setParameter(processor, "HighCut Slope", static_cast<float>(setup.highCutSlope));
+    setParameter(processor, "Phase Mode", setup.linearPhase ? 1.f : 0.f);
+    setParameter(processor, "Oversampling", static_cast<float>(setup.oversampling));
+    setParameter(processor, "Oversampling Filter", static_cast<float>(setup.oversamplingFilter));
+    setParameter(processor, "Precision", setup.precision == 1 ? 1.f : 0.f);
+    setParameter(processor, "Filter Topology", setup.stateVariable ? 1.f : 0.f);
+
+    // Hosts pick the precision before preparing, and then hand over buffers of that type.
+    processor.setProcessingPrecision(setup.precision == 2 ? juce::AudioProcessor::doublePrecision
+                                                          : juce::AudioProcessor::singlePrecision);
+    processor.setPlayConfigDetails(setup.numChannels, setup.numChannels, setup.sampleRate, setup.blockSize);
+    processor.prepareToPlay(setup.sampleRate, setup.blockSize);
+
+    if (setup.precision == 2)
+        measureProcessBlock<double>(runner, processor, setup);
+    else
+        measureProcessBlock<float>(runner, processor, setup);
+
+    processor.releaseResources();
+}
+
+static void addProcessCases(BenchmarkRunner& runner, bool full)
+{
+    const int blockSizes[] { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const double sampleRates[] { 44100.0, 48000.0, 96000.0, 192000.0, 384000.0 };
+    const int channelCounts[] { 1, 2, 6, 12 };   // Mono, stereo, 5.1 and 7.1.4.
+    const int numSlopes = 5;
+
+    juce::Array<ProcessCase> setups;
+
+    if (full)
+    {
+        for (auto blockSize : blockSizes)
+            for (auto sampleRate : sampleRates)
+                for (auto numChannels : channelCounts)
+                    for (int low = 0; low < numSlopes; ++low)
+                        for (int high = 0; high < numSlopes; ++high)
+                            for (auto automated : { false, true })
+                                for (auto linearPhase : { false, true })
+                                    for (int oversampling = 0; oversampling <= (linearPhase ? 0 : 3); ++oversampling)
+                                        setups.add({ blockSize, sampleRate, numChannels, low, high, automated, linearPhase, oversampling, 0 });
+    }
+    else
+    {
+        const ProcessCase typical;
+
+        for (auto blockSize : blockSizes)
+            setups.add({ blockSize, typical.sampleRate, typical.numChannels, 0, 0, false });
+
+        for (auto sampleRate : sampleRates)
+            setups.add({ typical.blockSize, sampleRate, typical.numChannels, 0, 0, false });
+
+        for (auto numChannels : channelCounts)
+            setups.add({ typical.blockSize, typical.sampleRate, numChannels, 0, 0, false });
+
+        for (int low = 0; low < numSlopes; ++low)
+            for (int high = 0; high < numSlopes; ++high)
+                setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, low, high, false });
+
+        for (auto blockSize : { 64, 256, 1024 })
+            for (auto automated : { false, true })
+                setups.add({ blockSize, typical.sampleRate, typical.numChannels, 3, 3, automated });
+
+        // The kernel grows with the sample rate, up to 64k taps at 384 kHz, but the cost per sample shouldn't.
+        for (auto sampleRate : sampleRates)
+            setups.add({ typical.blockSize, sampleRate, typical.numChannels, 0, 0, false, true });
+
+        for (auto blockSize : { 64, 1024 })
+            setups.add({ blockSize, typical.sampleRate, typical.numChannels, 0, 0, true, true });
+
+        // Every oversampling factor with both kinds of half-band filter, plus 4x IIR under automation.
+        for (int oversampling = 1; oversampling <= 3; ++oversampling)
+            for (int filter = 0; filter < 2; ++filter)
+                setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, 0, 0, false, false, oversampling, filter });
+
+        setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, 3, 3, true, false, 2, 0 });
+
+        // The cost should grow by one biquad per active band, whatever the band count.
+        for (auto numActiveBands : { 0, 4, 8, 16, 24 })
+            setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, 0, 0, false, false, 0, 0, numActiveBands });
+
+        // Every dynamic band redesigning itself every 32 samples, with and without oversampling.
+        for (auto oversampling : { 0, 2 })
+            setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, 0, 0, false, false, oversampling, 0, maxDynamicBands, maxDynamicBands });
+
+        /* Float, mixed and double precision with a 48 dB/Oct low cut and the first 8 bands active, most of which sit
+         * below 250 Hz. Mixed should cost far less than double, however many channels and whatever the rate.
+         */
+        for (auto sampleRate : { 48000.0, 192000.0, 384000.0 })
+            for (auto numChannels : { 2, 12 })
+                for (int precision = 0; precision < 3; ++precision)
+                    setups.add({ typical.blockSize, sampleRate, numChannels, 3, 0, false, false, 0, 0, 8, 0, precision });
+
+        // The state variable form against the direct form cases above, on the cuts, with bands, and under automation.
+        setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, 3, 3, false, false, 0, 0, 1, 0, 0, true });
+        setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, 3, 3, true, false, 0, 0, 1, 0, 0, true });
+
+        for (auto numActiveBands : { 8, 24 })
+            setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, 0, 0, false, false, 0, 0, numActiveBands, 0, 0, true });
+
+        for (auto numChannels : { 2, 12 })
+            setups.add({ typical.blockSize, 384000.0, numChannels, 3, 0, false, false, 0, 0, 8, 0, 0, true });
+
+        /* Sample-accurate automation against the whole-block cases above: a few points per block, and one every few
+         * samples, which the splitter coalesces down to one redesign per 32 samples.
+         */
+        for (auto blockSize : { 256, 1024 })
+            for (auto breakpoints : { 4, 32 })
+                setups.add({ blockSize, typical.sampleRate, typical.numChannels, 3, 3, true, false, 0, 0, 1, 0, 0, false, false, breakpoints });
+
+        /* Each channel mode against linked, with half the bands on each channel group. Every group loads the same one
+         * design, so the modes should cost about what linked does; mid/side adds only the coding in the interleave.
+         */
+        for (int channelMode = 0; channelMode < 3; ++channelMode)
+            setups.add({ typical.blockSize, typical.sampleRate, 2, 3, 3, false, false, 0, 0, 8, 0, 0, false, false, 0, channelMode });
+
+        setups.add({ typical.blockSize, typical.sampleRate, 12, 3, 3, false, false, 0, 0, 8, 0, 0, false, false, 0, 3 });
+
+        // Silent input, which an idle instance should get through for next to nothing, whatever the settings.
+        setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, 0, 0, false, false, 0, 0, 1, 0, 0, false, true });
+        setups.add({ typical.blockSize, typical.sampleRate, 12, 3, 3, false, false, 2, 0, 24, 0, 0, false, true });
+        setups.add({ typical.blockSize, typical.sampleRate, typical.numChannels, 0, 0, false, true, 0, 0, 1, 0, 0, false, true });
+    }
+
+    for (const auto& setup : setups)
+        runner.add(setup.getName(), [setup](BenchmarkRunner& r) { benchmarkProcessBlock(r, setup); });
+}
+
+// The cost of designing a complete coefficient set, which is what the coefficient pipeline does on every change.
+static void addDesignCases(BenchmarkRunner& runner)
+{
+    for (int low = 0; low < 5; ++low)
+    {
+        for (int high = 0; high < 5; ++high)
+        {
+            runner.add("design/slopes:" + juce::String(low) + "x" + juce::String(high), [low, high](BenchmarkRunner& r)
+            {
+                ChainSettings settings;
+                settings.lowCutFrequency = 80.f;
+                settings.highCutFrequency = 16000.f;
+                settings.bands[0] = { BandType::bell, 1000.f, 4.f, 1.f };
+                settings.lowCutSlope = low;
+                settings.highCutSlope = high;
+
+                // Sink the result somewhere the optimiser can't see through, so the design isn't thrown away.
+                static volatile double sink = 0.0;
+
+                r.measure(0.0, 0.0, [&]
+                {
+                    auto& frequency = settings.bands[0].frequency;
+                    frequency = frequency < 5000.f ? frequency + 1.f : 1000.f;
+                    sink = CoefficientDesign::makeChainCoefficients(settings, 48000.0).bands[0].b0;
+                });
+            });
+        }
+    }
+}
+
+// The cost of designing a single band from scratch, which is what audio-rate modulation of a band would pay per update.
+static void addBandDesignCases(BenchmarkRunner& runner)
+{
+    const std::pair<const char*, BandType> types[] { { "bell", BandType::bell }, { "low-shelf", BandType::lowShelf },
+                                                     { "notch", BandType::notch }, { "tilt", BandType::tilt } };
+
+    for (auto [name, type] : types)
+    {
+        runner.add("design/band:" + juce::String(name), [type = type](BenchmarkRunner& r)
+        {
+            BandSettings band { type, 1000.f, 4.f, 1.f };
+            static volatile double sink = 0.0;
+
+            r.measure(0.0, 0.0, [&]
+            {
+                band.frequency = band.frequency < 5000.f ? band.frequency + 1.f : 1000.f;
+                sink = CoefficientDesign::makeBand(48000.0, band).b0;
+            });
+        });
+    }
+}
+
+/* The cost of loading an instance, which a large session pays once per instance when it opens. The prepare cases
+ * include construction; linear phase also builds the convolver, which otherwise waits until it's selected.
+ */
+static void addStartupCases(BenchmarkRunner& runner)
+{
+    runner.add("startup/construct", [](BenchmarkRunner& r)
+    {
+        r.measure(0.0, 0.0, [] { BasicEQAudioProcessor processor; });
+    });
+
+    for (const auto linearPhase : { false, true })
+    {
+        runner.add(juce::String("startup/prepare") + (linearPhase ? "/linear-phase" : ""), [linearPhase](BenchmarkRunner& r)
+        {
+            r.measure(0.0, 0.0, [linearPhase]
+            {
+                BasicEQAudioProcessor processor;
+                setParameter(processor, "Phase Mode", linearPhase ? 1.f : 0.f);
+
+                processor.setPlayConfigDetails(2, 2, 48000.0, 512);
+                processor.prepareToPlay(48000.0, 512);
+                processor.releaseResources();
+            });
+        });
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments(argc, argv);
+
+    BenchmarkRunner::Options options;
+    options.filter = arguments.getValueForOption("--filter");
+
+    if (arguments.containsOption("--min-time"))
+        options.minSecondsPerRepetition = arguments.getValueForOption("--min-time").getDoubleValue();
+
+    if (arguments.containsOption("--repetitions"))
+        options.repetitions = arguments.getValueForOption("--repetitions").getIntValue();
+
+    BenchmarkRunner runner;
+    addProcessCases(runner, arguments.containsOption("--full"));
+    addDesignCases(runner);
+    addBandDesignCases(runner);
+    addStartupCases(runner);
+
+    const auto results = runner.run(options);
+
+    if (arguments.containsOption("--json"))
+    {
+        const auto file = arguments.getFileForOption("--json");
+
+        if (! file.replaceWithText(juce::JSON::toString(BenchmarkRunner::toJson(results))))
+        {
+            std::cerr << "Couldn't write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if (arguments.containsOption("--baseline"))
+    {
+        const auto baseline = juce::JSON::parse(arguments.getExistingFileForOption("--baseline"));
+        const auto maxRegression = arguments.containsOption("--max-regression")
+                                 ? arguments.getValueForOption("--max-regression").getDoubleValue()
+                                 : 10.0;
+
+        const auto numRegressions = BenchmarkRunner::compareWithBaseline(results, baseline, maxRegression);
+
+        if (numRegressions > 0)
+        {
+            std::cout << numRegressions << " case(s) regressed by more than " << maxRegression << "%" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    AnalyzerFifo.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalyzerFifo.h"
+
+template <typename SampleType>
+void AnalyzerFifo::push(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    const auto numChannels = block.getNumChannels();
+
+    if (! active.load(std::memory_order_relaxed) || numChannels == 0)
+        return;
+
+    const auto gain = static_cast<SampleType>(1) / static_cast<SampleType>(numChannels);
+
+    // The write is clipped to the free space, and may wrap around, in which case the block goes in as two pieces.
+    const auto scope = fifo.write(static_cast<int>(block.getNumSamples()));
+    int offset = 0;
+
+    for (auto [start, size] : { std::pair<int, int> { scope.startIndex1, scope.blockSize1 },
+                                std::pair<int, int> { scope.startIndex2, scope.blockSize2 } })
+    {
+        if (size <= 0)
+            continue;
+
+        auto* destination = samples.data() + start;
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            juce::FloatVectorOperations::copyWithMultiply(destination, block.getChannelPointer(0) + offset, gain, size);
+
+            for (size_t channel = 1; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::addWithMultiply(destination, block.getChannelPointer(channel) + offset, gain, size);
+        }
+        else
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                SampleType sum = 0;
+
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                    sum += block.getChannelPointer(channel)[offset + i];
+
+                destination[i] = static_cast<float>(sum * gain);
+            }
+        }
+
+        offset += size;
+    }
+}
+
+template void AnalyzerFifo::push(const juce::dsp::AudioBlock<float>&) noexcept;
+template void AnalyzerFifo::push(const juce::dsp::AudioBlock<double>&) noexcept;
+
+int AnalyzerFifo::pull(float* destination, int maxSamples) noexcept
+{
+    const auto scope = fifo.read(juce::jmin(maxSamples, fifo.getNumReady()));
+
+    std::copy(samples.data() + scope.startIndex1, samples.data() + scope.startIndex1 + scope.blockSize1, destination);
+    std::copy(samples.data() + scope.startIndex2, samples.data() + scope.startIndex2 + scope.blockSize2, destination + scope.blockSize1);
+
+    return scope.blockSize1 + scope.blockSize2;
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    AnalyzerFifo.h
+
+    Carries the processed signal from the audio thread to the editor's
+    spectrum analyzer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/* A single-producer, single-consumer sample queue. The audio thread mixes each block down to mono and writes it in;
+ * the analyzer's background thread reads it out. Neither side ever locks or allocates.
+ *
+ * Nothing is written unless an analyzer has said it's listening, so a session full of closed editors costs nothing.
+ * If the reader falls behind, whatever doesn't fit is simply dropped; the analyzer only needs the most recent signal.
+ */
+class AnalyzerFifo
+{
+public:
+    // Message thread, from prepareToPlay(). The analyzer needs the rate to place its frequency bins.
+    void setSampleRate(double newSampleRate) noexcept   { sampleRate = newSampleRate; }
+    double getSampleRate() const noexcept               { return sampleRate.load(); }
+
+    // Called by the analyzer when it starts and stops reading.
+    void setActive(bool shouldBeActive) noexcept        { active = shouldBeActive; }
+
+    // Audio thread. Mixes the block down to mono and queues as much of it as fits. Double blocks are rounded to float.
+    template <typename SampleType>
+    void push(const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    // Analyzer thread. Reads up to maxSamples into destination, and returns how many it read.
+    int pull(float* destination, int maxSamples) noexcept;
+
+private:
+    static constexpr int capacity = 1 << 15;
+
+    juce::AbstractFifo fifo { capacity };
+    std::array<float, capacity> samples {};
+
+    std::atomic<bool> active { false };
+    std::atomic<double> sampleRate { 44100.0 };
+};
@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    AutomationSplitter.cpp
+
+  ==============================================================================
+*/
+
+#include "AutomationSplitter.h"
+#include "PluginProcessor.h"
+
+void AutomationSplitter::addTarget(juce::RangedAudioParameter& parameter, std::atomic<float>& rawValue, Field field, int band)
+{
+    const auto index = static_cast<size_t>(parameter.getParameterIndex());
+
+    if (targets.size() <= index)
+        targets.resize(index + 1);
+
+    targets[index] = { field, band, &parameter, &rawValue };
+}
+
+bool AutomationSplitter::addChange(int parameterIndex, int sampleOffset, float normalisedValue) noexcept
+{
+    if (! juce::isPositiveAndBelow(parameterIndex, static_cast<int>(targets.size()))
+        || targets[static_cast<size_t>(parameterIndex)].field == Field::none
+        || numChanges == maxChangesPerBlock)
+        return false;
+
+    changes[static_cast<size_t>(numChanges++)] = { juce::jmax(0, sampleOffset), parameterIndex, normalisedValue };
+    return true;
+}
+
+int AutomationSplitter::beginBlock(int numSamples, ChainSettings& settings) noexcept
+{
+    /* Hosts send changes grouped by parameter, so they need putting in time order. A stable sort keeps two changes to
+     * the same parameter at the same offset in the order they came; std::stable_sort may allocate, so this is an
+     * insertion sort, which is quick for the handful of changes a block usually has.
+     */
+    for (int i = 1; i < numChanges; ++i)
+    {
+        const auto change = changes[static_cast<size_t>(i)];
+        auto j = i;
+
+        for (; j > 0 && changes[static_cast<size_t>(j - 1)].sampleOffset > change.sampleOffset; --j)
+            changes[static_cast<size_t>(j)] = changes[static_cast<size_t>(j - 1)];
+
+        changes[static_cast<size_t>(j)] = change;
+    }
+
+    // Parameters that move in this block hold their old values until their first change; everything else is read now.
+    const auto previous = settings;
+    readSettings(settings);
+
+    for (int i = 0; i < numChanges; ++i)
+    {
+        const auto& target = targets[static_cast<size_t>(changes[static_cast<size_t>(i)].parameterIndex)];
+        setField(settings, target, getField(previous, target));
+    }
+
+    // The block always starts a segment. Each change starts another, unless it's too close to the last one to be worth it.
+    numSegments = 1;
+    segments[0] = { 0, numSamples, 0, 0 };
+
+    for (int i = 0; i < numChanges; ++i)
+    {
+        const auto offset = juce::jmin(changes[static_cast<size_t>(i)].sampleOffset, juce::jmax(0, numSamples - 1));
+        auto* current = &segments[static_cast<size_t>(numSegments - 1)];
+
+        if (offset - current->start >= minimumSegmentLength)
+        {
+            current->length = offset - current->start;
+            current = &segments[static_cast<size_t>(numSegments++)];
+            *current = { offset, numSamples - offset, i, 0 };
+        }
+
+        ++current->numChanges;
+    }
+
+    return numSegments;
+}
+
+bool AutomationSplitter::applySegment(int index, ChainSettings& settings, ChangedParts& changed) const noexcept
+{
+    const auto& segment = getSegment(index);
+    changed = {};
+
+    for (int i = segment.firstChange; i < segment.firstChange + segment.numChanges; ++i)
+    {
+        const auto& change = changes[static_cast<size_t>(i)];
+        const auto& target = targets[static_cast<size_t>(change.parameterIndex)];
+        const auto previous = settings.numBands;
+
+        setField(settings, target, target.parameter->convertFrom0to1(change.value));
+
+        // The band count is the one field that reaches more than one band.
+        if (target.field == Field::numBands)
+        {
+            for (auto band = juce::jmin(previous, settings.numBands); band < juce::jmax(previous, settings.numBands); ++band)
+                changed.bands |= 1u << band;
+
+            continue;
+        }
+
+        markChanged(changed, target);
+    }
+
+    return segment.numChanges > 0;
+}
+
+void AutomationSplitter::endBlock(ChainSettings& settings) noexcept
+{
+    numChanges = 0;
+    numSegments = 0;
+    readSettings(settings);
+}
+
+void AutomationSplitter::readSettings(ChainSettings& settings) const noexcept
+{
+    for (const auto& target : targets)
+        if (target.field != Field::none)
+            setField(settings, target, target.rawValue->load());
+}
+
+void AutomationSplitter::markChanged(ChangedParts& changed, const Target& target) noexcept
+{
+    const auto bandBit = 1u << target.band;
+
+    // Only the first few bands have dynamics, and their design also depends on the band's own shape.
+    const auto dynamicBit = target.band < maxDynamicBands ? bandBit : 0u;
+
+    switch (target.field)
+    {
+        case Field::lowCutFrequency:
+        case Field::lowCutSlope:        changed.lowCut = true; break;
+        case Field::highCutFrequency:
+        case Field::highCutSlope:       changed.highCut = true; break;
+        case Field::lowCutPlacement:
+        case Field::highCutPlacement:
+        case Field::bandPlacement:      changed.placements = true; break;
+        case Field::bandType:
+        case Field::bandFrequency:
+        case Field::bandGain:
+        case Field::bandQuality:
+        case Field::bandDynamic:        changed.bands |= bandBit; changed.dynamics |= dynamicBit; break;
+        case Field::bandThreshold:
+        case Field::bandRatio:
+        case Field::bandAttack:
+        case Field::bandRelease:
+        case Field::bandSidechain:      changed.dynamics |= dynamicBit; break;
+        case Field::numBands:
+        case Field::none:               break;
+    }
+}
+
+// These convert values the same way getChainSettings() does.
+void AutomationSplitter::setField(ChainSettings& settings, const Target& target, float value) noexcept
+{
+    auto& band = settings.bands[static_cast<size_t>(target.band)];
+
+    switch (target.field)
+    {
+        case Field::lowCutFrequency:    settings.lowCutFrequency = value; break;
+        case Field::highCutFrequency:   settings.highCutFrequency = value; break;
+        case Field::lowCutSlope:        settings.lowCutSlope = static_cast<int>(value); break;
+        case Field::highCutSlope:       settings.highCutSlope = static_cast<int>(value); break;
+        case Field::lowCutPlacement:    settings.lowCutPlacement = static_cast<ChannelPlacement>(static_cast<int>(value)); break;
+        case Field::highCutPlacement:   settings.highCutPlacement = static_cast<ChannelPlacement>(static_cast<int>(value)); break;
+        case Field::numBands:           settings.numBands = static_cast<int>(value); break;
+        case Field::bandType:           band.type = static_cast<BandType>(static_cast<int>(value)); break;
+        case Field::bandFrequency:      band.frequency = value; break;
+        case Field::bandGain:           band.gainDecibels = value; break;
+        case Field::bandQuality:        band.quality = value; break;
+        case Field::bandPlacement:      band.placement = static_cast<ChannelPlacement>(static_cast<int>(value)); break;
+        case Field::bandDynamic:        band.dynamic = value > 0.5f; break;
+        case Field::bandThreshold:      band.thresholdDecibels = value; break;
+        case Field::bandRatio:          band.ratio = value; break;
+        case Field::bandAttack:         band.attackMilliseconds = value; break;
+        case Field::bandRelease:        band.releaseMilliseconds = value; break;
+        case Field::bandSidechain:      band.useSidechain = value > 0.5f; break;
+        case Field::none:               break;
+    }
+}
+
+float AutomationSplitter::getField(const ChainSettings& settings, const Target& target) noexcept
+{
+    const auto& band = settings.bands[static_cast<size_t>(target.band)];
+
+    switch (target.field)
+    {
+        case Field::lowCutFrequency:    return settings.lowCutFrequency;
+        case Field::highCutFrequency:   return settings.highCutFrequency;
+        case Field::lowCutSlope:        return static_cast<float>(settings.lowCutSlope);
+        case Field::highCutSlope:       return static_cast<float>(settings.highCutSlope);
+        case Field::lowCutPlacement:    return static_cast<float>(settings.lowCutPlacement);
+        case Field::highCutPlacement:   return static_cast<float>(settings.highCutPlacement);
+        case Field::numBands:           return static_cast<float>(settings.numBands);
+        case Field::bandType:           return static_cast<float>(band.type);
+        case Field::bandFrequency:      return band.frequency;
+        case Field::bandGain:           return band.gainDecibels;
+        case Field::bandQuality:        return band.quality;
+        case Field::bandPlacement:      return static_cast<float>(band.placement);
+        case Field::bandDynamic:        return band.dynamic ? 1.f : 0.f;
+        case Field::bandThreshold:      return band.thresholdDecibels;
+        case Field::bandRatio:          return band.ratio;
+        case Field::bandAttack:         return band.attackMilliseconds;
+        case Field::bandRelease:        return band.releaseMilliseconds;
+        case Field::bandSidechain:      return band.useSidechain ? 1.f : 0.f;
+        case Field::none:               break;
+    }
+
+    return 0.f;
+}
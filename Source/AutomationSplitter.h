@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    AutomationSplitter.h
+
+    Cuts a block at the points where parameters changed within it, so that
+    automation lands on the right sample rather than at the start of the block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterDesign.h"
+
+/* JUCE applies a host's parameter changes before processBlock(), so however far into a buffer an automation point
+ * really was, it takes effect at the start. A wrapper or tool that knows the real positions (VST3 parameter queues
+ * carry them, and so does anything rendering offline) queues them here, and processBlock() then processes the block
+ * in segments. Each segment redesigns just the filters its changes touch, from a copy of the settings kept on the
+ * audio thread.
+ *
+ * Dense automation would otherwise mean a redesign every few samples, so changes closer together than
+ * minimumSegmentLength are applied together, at the first of them. That bounds the redesigns at one per
+ * minimumSegmentLength samples, the same spacing the smoothing sub-blocks use. Everything lives in fixed arrays
+ * sized up front, so queueing, splitting and applying changes never allocates.
+ */
+class AutomationSplitter
+{
+public:
+    // Changes less than this many samples after the start of a segment are applied at its start.
+    static constexpr int minimumSegmentLength = 32;
+
+    // More changes than this in one block are applied at the start of the next, as they would be without splitting.
+    static constexpr int maxChangesPerBlock = 512;
+
+    // The part of ChainSettings a parameter drives.
+    enum class Field
+    {
+        none,
+        lowCutFrequency,
+        highCutFrequency,
+        lowCutSlope,
+        highCutSlope,
+        lowCutPlacement,
+        highCutPlacement,
+        numBands,
+        bandType,
+        bandFrequency,
+        bandGain,
+        bandQuality,
+        bandPlacement,
+        bandDynamic,
+        bandThreshold,
+        bandRatio,
+        bandAttack,
+        bandRelease,
+        bandSidechain
+    };
+
+    /* Tells the splitter which part of the settings a parameter drives, and where to read its current value.
+     * Parameters that aren't added are ignored. Not real-time safe; call it before processing starts.
+     */
+    void addTarget(juce::RangedAudioParameter& parameter, std::atomic<float>& rawValue, Field field, int band = 0);
+
+    /* Queues a change for the next block, sampleOffset samples in, with a normalised value as for
+     * setValueNotifyingHost(). Returns false if the parameter isn't one the splitter knows, or the queue is full.
+     * Audio thread only, before processBlock(); real-time safe.
+     */
+    bool addChange(int parameterIndex, int sampleOffset, float normalisedValue) noexcept;
+
+    bool hasChanges() const noexcept { return numChanges > 0; }
+
+    // A run of samples with the same settings, and the queued changes that take effect at its start.
+    struct Segment
+    {
+        int start { 0 };
+        int length { 0 };
+        int firstChange { 0 };
+        int numChanges { 0 };
+    };
+
+    /* Sorts the queued changes into segments for a block of numSamples, and returns how many there are.
+     * The settings should be as they were at the end of the last block; parameters with no changes queued
+     * are brought up to date, and those with changes are left where they were until their first change.
+     */
+    int beginBlock(int numSamples, ChainSettings& settings) noexcept;
+
+    const Segment& getSegment(int index) const noexcept { return segments[static_cast<size_t>(index)]; }
+
+    /* Which parts of the chain a segment's changes touch, so only those need designing again. Bits are per band;
+     * a band's filter and its dynamics depend on different parameters, so they're marked separately.
+     */
+    struct ChangedParts
+    {
+        bool lowCut { false };
+        bool highCut { false };
+        bool placements { false };
+        juce::uint32 bands { 0 };
+        juce::uint32 dynamics { 0 };
+    };
+
+    /* Writes a segment's changes into the settings, and marks what they touch in changed. Returns false if it
+     * didn't have any.
+     */
+    bool applySegment(int index, ChainSettings& settings, ChangedParts& changed) const noexcept;
+
+    /* Forgets the block's changes and reads every parameter into the settings, ready for the next block.
+     * Call it at the end of every block, split or not.
+     */
+    void endBlock(ChainSettings& settings) noexcept;
+
+private:
+    struct Target
+    {
+        Field field { Field::none };
+        int band { 0 };
+        juce::RangedAudioParameter* parameter { nullptr };
+        std::atomic<float>* rawValue { nullptr };
+    };
+
+    struct Change
+    {
+        int sampleOffset;
+        int parameterIndex;
+        float value;
+    };
+
+    static void setField(ChainSettings& settings, const Target& target, float value) noexcept;
+    static void markChanged(ChangedParts& changed, const Target& target) noexcept;
+    static float getField(const ChainSettings& settings, const Target& target) noexcept;
+
+    void readSettings(ChainSettings& settings) const noexcept;
+
+    // Indexed by parameter index.
+    std::vector<Target> targets;
+
+    std::array<Change, maxChangesPerBlock> changes;
+    int numChanges { 0 };
+
+    // At most one segment per change, plus the one the block starts with.
+    std::array<Segment, maxChangesPerBlock + 1> segments;
+    int numSegments { 0 };
+};
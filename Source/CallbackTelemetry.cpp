@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    CallbackTelemetry.cpp
+
+  ==============================================================================
+*/
+
+#include "CallbackTelemetry.h"
+
+#if BASICEQ_TELEMETRY
+
+// Drains the ring a few times a second.
+class CallbackTelemetry::Aggregator  : public juce::Thread
+{
+public:
+    explicit Aggregator(CallbackTelemetry& t) : juce::Thread("BasicEQ Telemetry"), telemetry(t) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            telemetry.drain();
+            wait(100);
+        }
+
+        telemetry.drain();
+    }
+
+private:
+    CallbackTelemetry& telemetry;
+};
+
+//==============================================================================
+void CallbackTelemetry::Histogram::add(double value) noexcept
+{
+    ++total;
+    largest = juce::jmax(largest, value);
+
+    const auto position = std::log(juce::jlimit(minimum, maximum, value) / minimum) / std::log(maximum / minimum);
+    ++counts[static_cast<size_t>(juce::jlimit(0, numBins - 1, static_cast<int>(position * (numBins - 1))))];
+}
+
+double CallbackTelemetry::Histogram::getPercentile(double fraction) const noexcept
+{
+    if (total == 0)
+        return 0.0;
+
+    const auto target = static_cast<juce::int64>(std::ceil(fraction * static_cast<double>(total)));
+    juce::int64 seen = 0;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        seen += counts[static_cast<size_t>(bin)];
+
+        // Report the upper edge of the bin, so the figure errs on the pessimistic side.
+        if (seen >= target)
+            return juce::jmin(largest, minimum * std::pow(maximum / minimum, static_cast<double>(bin + 1) / (numBins - 1)));
+    }
+
+    return largest;
+}
+
+void CallbackTelemetry::Histogram::clear() noexcept
+{
+    counts.fill(0);
+    total = 0;
+    largest = 0.0;
+}
+
+//==============================================================================
+CallbackTelemetry::CallbackTelemetry()
+{
+    // From a tenth of a microsecond up to 100ms of CPU time, and from 0.01% up to 10x the deadline.
+    cpuHistogram.minimum = 0.1;
+    cpuHistogram.maximum = 100000.0;
+    deadlineHistogram.minimum = 0.0001;
+    deadlineHistogram.maximum = 10.0;
+}
+
+CallbackTelemetry::~CallbackTelemetry()
+{
+    release();
+}
+
+void CallbackTelemetry::prepare(double sampleRate)
+{
+    release();
+
+    currentSampleRate = sampleRate;
+    ring.reset();
+
+    aggregator = std::make_unique<Aggregator>(*this);
+    aggregator->startThread();
+}
+
+void CallbackTelemetry::release()
+{
+    if (aggregator != nullptr)
+    {
+        aggregator->stopThread(1000);
+        aggregator.reset();
+    }
+}
+
+void CallbackTelemetry::beginCallback() noexcept
+{
+    callbackStartTicks = juce::Time::getHighResolutionTicks();
+}
+
+void CallbackTelemetry::endCallback(int numSamples) noexcept
+{
+    const auto cpuSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - callbackStartTicks);
+    const auto bufferSeconds = numSamples / currentSampleRate.load(std::memory_order_relaxed);
+
+    pending.cpuMicroseconds = static_cast<float>(cpuSeconds * 1.0e6);
+    pending.deadlineRatio = bufferSeconds > 0.0 ? static_cast<float>(cpuSeconds / bufferSeconds) : 0.f;
+
+    const auto scope = ring.write(1);
+
+    if (scope.blockSize1 + scope.blockSize2 > 0)
+        records[static_cast<size_t>(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = pending;
+    else
+        droppedRecords.fetch_add(1, std::memory_order_relaxed);
+
+    pending = {};
+}
+
+void CallbackTelemetry::drain()
+{
+    const juce::ScopedLock sl(lock);
+
+    for (;;)
+    {
+        const auto scope = ring.read(1);
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            break;
+
+        const auto& record = records[static_cast<size_t>(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+
+        cpuHistogram.add(record.cpuMicroseconds);
+        deadlineHistogram.add(record.deadlineRatio);
+
+        ++totals.numCallbacks;
+        totals.coefficientUpdates += record.coefficientUpdates;
+        totals.denormalGuardHits += record.denormalGuardHits;
+        totals.stateResets += record.stateResets;
+        totals.silentCallbacks += record.silent ? 1 : 0;
+    }
+}
+
+CallbackTelemetry::Snapshot CallbackTelemetry::getSnapshot() const
+{
+    const juce::ScopedLock sl(lock);
+
+    auto snapshot = totals;
+    snapshot.cpuMicrosecondsP50 = cpuHistogram.getPercentile(0.5);
+    snapshot.cpuMicrosecondsP99 = cpuHistogram.getPercentile(0.99);
+    snapshot.cpuMicrosecondsMax = cpuHistogram.largest;
+    snapshot.deadlineRatioP50 = deadlineHistogram.getPercentile(0.5);
+    snapshot.deadlineRatioP99 = deadlineHistogram.getPercentile(0.99);
+    snapshot.deadlineRatioMax = deadlineHistogram.largest;
+    snapshot.droppedRecords = droppedRecords.load();
+
+    return snapshot;
+}
+
+void CallbackTelemetry::reset()
+{
+    const juce::ScopedLock sl(lock);
+
+    cpuHistogram.clear();
+    deadlineHistogram.clear();
+    totals = {};
+    droppedRecords = 0;
+}
+
+#endif
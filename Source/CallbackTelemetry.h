@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    CallbackTelemetry.h
+
+    Opt-in timing and counters for processBlock(). Build with
+    BASICEQ_TELEMETRY=1 to turn it on; otherwise every call below is an
+    empty inline function and compiles away.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef BASICEQ_TELEMETRY
+ #define BASICEQ_TELEMETRY 0
+#endif
+
+/* The audio thread writes one small record per callback into a lock-free ring buffer and never does anything else.
+ * A background thread drains the ring, folds the records into histograms, and keeps a snapshot of the percentiles
+ * that the editor (or anything else) can read at its leisure.
+ */
+class CallbackTelemetry
+{
+public:
+    // Aggregated figures since the last reset().
+    struct Snapshot
+    {
+        juce::int64 numCallbacks { 0 };
+
+        // CPU time spent in processBlock(), in microseconds.
+        double cpuMicrosecondsP50 { 0.0 }, cpuMicrosecondsP99 { 0.0 }, cpuMicrosecondsMax { 0.0 };
+
+        // CPU time divided by the duration of the buffer; 1.0 means the callback used its whole deadline.
+        double deadlineRatioP50 { 0.0 }, deadlineRatioP99 { 0.0 }, deadlineRatioMax { 0.0 };
+
+        juce::int64 coefficientUpdates { 0 };
+        juce::int64 denormalGuardHits { 0 };
+
+        // Times the filter state went NaN or infinite and was cleared, and callbacks skipped because of silence.
+        juce::int64 stateResets { 0 };
+        juce::int64 silentCallbacks { 0 };
+
+        // Records the audio thread had to throw away because the ring was full.
+        juce::int64 droppedRecords { 0 };
+    };
+
+    static constexpr bool isEnabled() noexcept { return BASICEQ_TELEMETRY != 0; }
+
+   #if BASICEQ_TELEMETRY
+    CallbackTelemetry();
+    ~CallbackTelemetry();
+
+    // Not real-time safe; call from prepareToPlay() and releaseResources().
+    void prepare(double sampleRate);
+    void release();
+
+    // Audio thread.
+    void beginCallback() noexcept;
+    void endCallback(int numSamples) noexcept;
+    void addCoefficientUpdate() noexcept           { ++pending.coefficientUpdates; }
+    void addDenormalGuardHits(int numHits) noexcept { pending.denormalGuardHits += numHits; }
+    void addStateReset() noexcept                  { ++pending.stateResets; }
+    void addSilentCallback() noexcept              { pending.silent = true; }
+
+    // Any thread other than the audio thread.
+    Snapshot getSnapshot() const;
+    void reset();
+   #else
+    void prepare(double) {}
+    void release() {}
+    void beginCallback() noexcept {}
+    void endCallback(int) noexcept {}
+    void addCoefficientUpdate() noexcept {}
+    void addDenormalGuardHits(int) noexcept {}
+    void addStateReset() noexcept {}
+    void addSilentCallback() noexcept {}
+    Snapshot getSnapshot() const { return {}; }
+    void reset() {}
+   #endif
+
+    // Times a callback for as long as it's in scope, so early returns are still counted.
+    struct ScopedCallback
+    {
+        ScopedCallback(CallbackTelemetry& t, int n) noexcept : telemetry(t), numSamples(n) { telemetry.beginCallback(); }
+        ~ScopedCallback() noexcept { telemetry.endCallback(numSamples); }
+
+        CallbackTelemetry& telemetry;
+        const int numSamples;
+    };
+
+   #if BASICEQ_TELEMETRY
+private:
+    struct Record
+    {
+        float cpuMicroseconds;
+        float deadlineRatio;
+        int coefficientUpdates;
+        int denormalGuardHits;
+        int stateResets;
+        bool silent;
+    };
+
+    // Log-spaced bins; percentiles are read from the bin edges, which is plenty for spotting trouble.
+    struct Histogram
+    {
+        static constexpr int numBins = 256;
+
+        void add(double value) noexcept;
+        double getPercentile(double fraction) const noexcept;
+        void clear() noexcept;
+
+        double minimum { 0.0 }, maximum { 0.0 };
+        std::array<juce::int64, numBins> counts {};
+        juce::int64 total { 0 };
+        double largest { 0.0 };
+    };
+
+    class Aggregator;
+
+    void drain();
+
+    static constexpr int ringSize = 2048;
+    juce::AbstractFifo ring { ringSize };
+    std::array<Record, ringSize> records {};
+
+    std::atomic<double> currentSampleRate { 44100.0 };
+    std::atomic<juce::int64> droppedRecords { 0 };
+
+    // Counters gathered during the current callback; only touched by the audio thread.
+    Record pending {};
+    juce::int64 callbackStartTicks { 0 };
+
+    // Owned by the aggregator thread, and read under the lock by getSnapshot().
+    juce::CriticalSection lock;
+    Histogram cpuHistogram, deadlineHistogram;
+    Snapshot totals;
+
+    std::unique_ptr<Aggregator> aggregator;
+   #endif
+};
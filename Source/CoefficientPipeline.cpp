@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    CoefficientPipeline.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientPipeline.h"
+#include "PluginProcessor.h"
+
+CoefficientPipeline::CoefficientPipeline(juce::AudioProcessorValueTreeState& state)
+    : apvts(state)
+{
+    // Listen to every parameter in the tree; any of them can change the coefficients.
+    for (auto* parameter : apvts.processor.getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            apvts.addParameterListener(withID->paramID, this);
+}
+
+CoefficientPipeline::~CoefficientPipeline()
+{
+    sharedResources->removeWorker(*this);
+
+    for (auto* parameter : apvts.processor.getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            apvts.removeParameterListener(withID->paramID, this);
+}
+
+ChainCoefficients CoefficientPipeline::prepare(double sampleRate)
+{
+    sharedResources->removeWorker(*this);
+
+    // With the worker stopped and the audio thread not running, nobody is using the queues.
+    readySlots.reset();
+    freeSlots.reset();
+
+    for (int i = 0; i < numSlots; ++i)
+        freeSlots.push(i);
+
+    currentSampleRate = sampleRate;
+    parametersChanged = false;
+
+    auto coefficients = CoefficientDesign::makeChainCoefficients(getChainSettings(apvts), sampleRate);
+
+    sharedResources->addWorker(*this);
+
+    return coefficients;
+}
+
+void CoefficientPipeline::release()
+{
+    sharedResources->removeWorker(*this);
+}
+
+bool CoefficientPipeline::pullLatest(ChainCoefficients& destination, juce::uint32* designedGeneration) noexcept
+{
+    // Skip over any sets that have already been superseded; we only care about the newest one.
+    int newest = -1, index = -1;
+
+    while (readySlots.pop(index))
+    {
+        if (newest >= 0)
+            freeSlots.push(newest);
+
+        newest = index;
+    }
+
+    if (newest < 0)
+        return false;
+
+    destination = slots[static_cast<size_t>(newest)];
+
+    if (designedGeneration != nullptr)
+        *designedGeneration = slotGenerations[static_cast<size_t>(newest)];
+
+    freeSlots.push(newest);
+
+    return true;
+}
+
+bool CoefficientPipeline::hasWork()
+{
+    return parametersChanged.load();
+}
+
+void CoefficientPipeline::doWork()
+{
+    if (parametersChanged.exchange(false) && ! publish())
+        parametersChanged = true;
+}
+
+void CoefficientPipeline::parameterChanged(const juce::String&, float)
+{
+    /* This can be called on the audio thread during automation, so all we do is set a flag.
+     * Handing the work to the pool directly would mean taking a lock.
+     */
+    ++generation;
+    parametersChanged = true;
+}
+
+bool CoefficientPipeline::publish()
+{
+    int index = -1;
+
+    if (! freeSlots.pop(index))
+        return false;
+
+    {
+        const juce::ScopedLock sl(designLock);
+
+        // Read before the parameters, so a change that lands in between makes the set look older, never newer.
+        slotGenerations[static_cast<size_t>(index)] = generation.load();
+        slots[static_cast<size_t>(index)] = CoefficientDesign::makeChainCoefficients(getChainSettings(apvts), currentSampleRate.load());
+    }
+
+    // This comes first, so anything the new set needs is ready before the audio thread can pick it up.
+    if (onPublished != nullptr)
+        onPublished(slots[static_cast<size_t>(index)]);
+
+    // With only numSlots indices in circulation, this can't fail; see IndexQueue.
+    const auto pushed = readySlots.push(index);
+    jassert(pushed);
+    juce::ignoreUnused(pushed);
+
+    return true;
+}
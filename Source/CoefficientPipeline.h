@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    CoefficientPipeline.h
+
+    Designs filter coefficients away from the audio thread and hands them over
+    without locks or allocations.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterDesign.h"
+#include "SharedResources.h"
+
+/* A single-producer, single-consumer queue of slot indices.
+ * juce::AbstractFifo only manages positions, so the indices themselves live in a fixed array next to it.
+ *
+ * Users keep a fixed pool of Capacity slots whose indices circulate between a ready queue and a free queue, plus
+ * whichever one each thread holds. No more than Capacity indices ever exist, so a push can never find the queue
+ * full; push() still reports it, so callers can assert on that.
+ */
+template <int Capacity>
+class IndexQueue
+{
+public:
+    bool push(int value) noexcept
+    {
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+
+        indices[static_cast<size_t>(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = value;
+        return true;
+    }
+
+    bool pop(int& value) noexcept
+    {
+        const auto scope = fifo.read(1);
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+
+        value = indices[static_cast<size_t>(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+        return true;
+    }
+
+    // Only safe while neither thread is using the queue.
+    void reset() noexcept { fifo.reset(); }
+
+private:
+    // An AbstractFifo always keeps one element free, so it needs one more than we want to store.
+    juce::AbstractFifo fifo { Capacity + 1 };
+    std::array<int, Capacity + 1> indices {};
+};
+
+/* The coefficient pipeline.
+ *
+ * The APVTS parameter listeners only flip an atomic flag, because hosts are free to call them from the
+ * audio thread. The shared worker pool (see SharedResources) polls that flag, reads a settings snapshot with
+ * getChainSettings(), and designs the new low cut, band and high cut coefficients into one of a handful of
+ * preallocated slots. The index of that slot is then pushed to the audio thread through a lock-free queue.
+ *
+ * The audio thread takes the newest index it can find, copies the coefficients out and gives every slot it
+ * touched straight back through a second queue. Slots are plain values that are simply reused, so nothing is
+ * ever freed, and the only thread that has to wait for a slot is the worker.
+ */
+class CoefficientPipeline  : private SharedResources::Worker,
+                             private juce::AudioProcessorValueTreeState::Listener
+{
+public:
+    explicit CoefficientPipeline(juce::AudioProcessorValueTreeState& apvts);
+    ~CoefficientPipeline() override;
+
+    /* Called from prepareToPlay(). Stops the background work, designs a first set of coefficients synchronously
+     * for the new sample rate, and then starts the background work again.
+     */
+    ChainCoefficients prepare(double sampleRate);
+
+    // Called from releaseResources(); stops the background work.
+    void release();
+
+    /* Audio thread only. If a newer set has been published since the last call, copies it into
+     * destination and returns true. Never blocks and never allocates. If designedGeneration isn't null, it's
+     * given the value getGeneration() had when the set's parameters were read.
+     */
+    bool pullLatest(ChainCoefficients& destination, juce::uint32* designedGeneration = nullptr) noexcept;
+
+    /* Counts parameter changes. The audio thread can design a set itself, for sample-accurate automation, and a set
+     * the worker designed from parameters read before that is older than what the audio thread already has.
+     */
+    juce::uint32 getGeneration() const noexcept { return generation.load(); }
+
+    /* Called on the worker with every set it publishes, just before the audio thread can see it, so other designers
+     * (like the linear phase kernel) can follow the parameters without polling them too, and anything the set needs
+     * can be got ready in time. Set it before the first prepare().
+     */
+    std::function<void(const ChainCoefficients&)> onPublished;
+
+    /* Holds the worker back while a whole preset is being applied one parameter at a time. Without it, the worker
+     * could take a snapshot halfway through and the audio thread would briefly glide towards a mix of two presets.
+     * The worker only ever waits on this lock itself; the audio thread never touches it.
+     */
+    class ScopedBatch
+    {
+    public:
+        explicit ScopedBatch(CoefficientPipeline& pipeline) : lock(pipeline.designLock) {}
+
+    private:
+        const juce::ScopedLock lock;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBatch)
+    };
+
+private:
+    bool hasWork() override;
+    void doWork() override;
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+    // Worker only. Returns false if no slot was free, in which case we try again on the next poll.
+    bool publish();
+
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+
+    juce::AudioProcessorValueTreeState& apvts;
+
+    // The worker holds at most one slot while the audio thread only ever holds one for the length of a copy.
+    static constexpr int numSlots = 4;
+
+    std::array<ChainCoefficients, numSlots> slots;
+    std::array<juce::uint32, numSlots> slotGenerations {};
+    IndexQueue<numSlots> readySlots, freeSlots;
+
+    // Held by the worker while it reads a snapshot and designs from it, and by a ScopedBatch.
+    juce::CriticalSection designLock;
+
+    std::atomic<bool> parametersChanged { false };
+    std::atomic<juce::uint32> generation { 0 };
+    std::atomic<double> currentSampleRate { 44100.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoefficientPipeline)
+};
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    CoefficientRamp.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientRamp.h"
+
+// Fills in the per-step increment that takes one section from its current value to its target.
+static void setIncrement(BiquadCoefficients& increment, const BiquadCoefficients& from, const BiquadCoefficients& to, double scale) noexcept
+{
+    increment.b0 = (to.b0 - from.b0) * scale;
+    increment.b1 = (to.b1 - from.b1) * scale;
+    increment.b2 = (to.b2 - from.b2) * scale;
+    increment.a1 = (to.a1 - from.a1) * scale;
+    increment.a2 = (to.a2 - from.a2) * scale;
+}
+
+static void addIncrement(BiquadCoefficients& value, const BiquadCoefficients& increment) noexcept
+{
+    value.b0 += increment.b0;
+    value.b1 += increment.b1;
+    value.b2 += increment.b2;
+    value.a1 += increment.a1;
+    value.a2 += increment.a2;
+}
+
+void CoefficientRamp::reset(const ChainCoefficients& coefficients) noexcept
+{
+    current = target = coefficients;
+    increment = {};
+    stepsRemaining = 0;
+}
+
+void CoefficientRamp::setTarget(const ChainCoefficients& newTarget, int numSteps) noexcept
+{
+    if (numSteps <= 0)
+    {
+        reset(newTarget);
+        return;
+    }
+
+    /* After an oversampling change the new set is designed for a different rate, and the engine gets cleared anyway,
+     * so there's nothing to glide between. The whole set jumps on the next step instead.
+     */
+    if (newTarget.sampleRate != current.sampleRate)
+    {
+        current = target = newTarget;
+        increment = {};
+        stepsRemaining = 1;
+        return;
+    }
+
+    target = newTarget;
+    stepsRemaining = numSteps;
+
+    // The dynamic bands follow their detectors instead of gliding, so their settings simply take over, as do placements.
+    current.dynamics = target.dynamics;
+    current.lowCutPlacement = target.lowCutPlacement;
+    current.highCutPlacement = target.highCutPlacement;
+    current.bandPlacements = target.bandPlacements;
+
+    const auto scale = 1.0 / numSteps;
+
+    // A band that's switched on glides in from a pass-through, and one that's switched off glides back out to one.
+    for (size_t i = 0; i < static_cast<size_t>(maxBands); ++i)
+        setIncrement(increment.bands[i], current.bands[i], target.bands[i], scale);
+
+    // A slope change swaps the whole cascade for a different one, so there's nothing sensible to glide between.
+    if (current.numLowCutSections != target.numLowCutSections)
+    {
+        current.lowCut = target.lowCut;
+        current.numLowCutSections = target.numLowCutSections;
+    }
+
+    if (current.numHighCutSections != target.numHighCutSections)
+    {
+        current.highCut = target.highCut;
+        current.numHighCutSections = target.numHighCutSections;
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(maxCutSections); ++i)
+    {
+        setIncrement(increment.lowCut[i], current.lowCut[i], target.lowCut[i], scale);
+        setIncrement(increment.highCut[i], current.highCut[i], target.highCut[i], scale);
+    }
+}
+
+const ChainCoefficients& CoefficientRamp::advance() noexcept
+{
+    if (stepsRemaining <= 0)
+        return current;
+
+    // Land exactly on the target on the last step, rather than wherever rounding errors have taken us.
+    if (--stepsRemaining == 0)
+    {
+        current = target;
+        return current;
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(maxBands); ++i)
+        addIncrement(current.bands[i], increment.bands[i]);
+
+    for (size_t i = 0; i < static_cast<size_t>(maxCutSections); ++i)
+    {
+        addIncrement(current.lowCut[i], increment.lowCut[i]);
+        addIncrement(current.highCut[i], increment.highCut[i]);
+    }
+
+    return current;
+}
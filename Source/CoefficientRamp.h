@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    CoefficientRamp.h
+
+    Glides between two coefficient sets in small, evenly sized steps.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterDesign.h"
+
+/* Applying a freshly designed coefficient set as a step change causes zipper noise when a band is automated
+ * quickly, but redesigning every biquad on every sample is far too expensive. Instead, processBlock() splits
+ * the buffer into sub-blocks of 16 to 64 samples and this class moves each coefficient a fixed amount
+ * towards its target at the start of every sub-block, so the cost per block is bounded no matter how busy the
+ * automation is.
+ *
+ * Interpolating biquad coefficients linearly keeps every intermediate filter stable: the region of (a1, a2)
+ * values with both poles inside the unit circle is a triangle, and a straight line between two points in a
+ * triangle never leaves it.
+ */
+class CoefficientRamp
+{
+public:
+    // Jumps straight to a coefficient set and stops any ramp in progress.
+    void reset(const ChainCoefficients& coefficients) noexcept;
+
+    /* Starts gliding towards a new set over numSteps sub-blocks.
+     * If a cut filter's slope has changed, its sections don't line up with the old ones, so that filter jumps instead.
+     * A set designed for a different sample rate jumps entirely.
+     */
+    void setTarget(const ChainCoefficients& target, int numSteps) noexcept;
+
+    bool isRamping() const noexcept { return stepsRemaining > 0; }
+
+    // Moves one step closer to the target and returns the coefficients to use for the next sub-block.
+    const ChainCoefficients& advance() noexcept;
+
+    const ChainCoefficients& getCurrent() const noexcept { return current; }
+
+private:
+    ChainCoefficients current, target, increment;
+    int stepsRemaining { 0 };
+};
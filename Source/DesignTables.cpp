@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    DesignTables.cpp
+
+  ==============================================================================
+*/
+
+#include "DesignTables.h"
+
+const DesignTables& DesignTables::getInstance()
+{
+    // Function-local statics are initialised exactly once, even when several instances prepare at the same time.
+    static const DesignTables instance;
+    return instance;
+}
+
+DesignTables::DesignTables()
+{
+    for (int i = 0; i <= numAngleSteps; ++i)
+    {
+        cosines[static_cast<size_t>(i)] = std::cos(i * angleStep);
+        sines[static_cast<size_t>(i)]   = std::sin(i * angleStep);
+    }
+
+    for (int i = 0; i <= numGainSteps; ++i)
+    {
+        const auto decibels = static_cast<double>(i) / decibelStepsPerUnit - maxTableDecibels;
+        gains[static_cast<size_t>(i)] = std::pow(10.0, decibels / 20.0);
+    }
+}
+
+DesignTables::CosSin DesignTables::getCosSin(double angle) const noexcept
+{
+    jassert(angle >= 0.0 && angle <= juce::MathConstants<double>::pi);
+
+    const auto index = juce::jlimit(0, numAngleSteps, static_cast<int>(angle * (1.0 / angleStep) + 0.5));
+    const auto d = angle - index * angleStep;
+    const auto dSquared = d * d;
+
+    // The next terms are d^6 / 720 and d^5 / 120, both far below double precision for |d| <= pi / 2048.
+    const auto cosD = 1.0 - dSquared * (0.5 - dSquared * (1.0 / 24.0));
+    const auto sinD = d * (1.0 - dSquared * (1.0 / 6.0));
+
+    const auto cosA = cosines[static_cast<size_t>(index)];
+    const auto sinA = sines[static_cast<size_t>(index)];
+
+    return { cosA * cosD - sinA * sinD,
+             sinA * cosD + cosA * sinD };
+}
+
+double DesignTables::getGain(double decibels) const noexcept
+{
+    if (! (std::abs(decibels) < maxTableDecibels))
+        return std::pow(10.0, decibels / 20.0);
+
+    const auto position = (decibels + maxTableDecibels) * decibelStepsPerUnit;
+    const auto index = juce::jlimit(0, numGainSteps, static_cast<int>(position + 0.5));
+
+    // What's left is at most 1/16 dB, so e^x with x = remainder * ln(10) / 20 needs only a few terms.
+    constexpr double naturalLogOfTen = 2.302585092994045684;
+    const auto x = (position - index) * (naturalLogOfTen / (20.0 * decibelStepsPerUnit));
+    const auto expX = 1.0 + x * (1.0 + x * (0.5 + x * (1.0 / 6.0 + x * (1.0 / 24.0))));
+
+    return gains[static_cast<size_t>(index)] * expX;
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    DesignTables.h
+
+    Precomputed trig and gain tables, so the filter designers never call
+    sin, cos, tan or pow.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/* Every filter design boils down to the cosine and sine of one angle (or of half of it, for the bilinear transform's
+ * tan), and a gain in decibels turned into a linear factor. This class answers both from tables, without calling
+ * into the maths library.
+ *
+ * Angles are looked up in a table of cos and sin over [0, pi], in normalised frequency, so a single table serves
+ * every sample rate. Rather than interpolating linearly, the remainder d between the angle and the nearest table entry
+ * is added back with the angle sum identities, using short Taylor series for cos d and sin d. With 1024 steps, |d| is
+ * at most pi / 2048, and the results are within 1e-15 of std::cos and std::sin. Gains work the same way: a table of
+ * 10^(dB / 20) in 1/8 dB steps, and a Taylor series for the rest, within a relative 2e-13 of std::pow.
+ *
+ * Q only ever enters the designs through a division, and gain through the factor above, so the tables don't need
+ * to cover either. A whole band comes out of a handful of multiplies and one division.
+ *
+ * The tables are immutable once built, so a single copy is shared read-only by every instance in the process.
+ * It's built the first time anything asks for it, which prepareToPlay() makes sure is never on the audio thread.
+ */
+class DesignTables
+{
+public:
+    // The process-wide tables, built on first use. Thread safe.
+    static const DesignTables& getInstance();
+
+    struct CosSin
+    {
+        double cos, sin;
+    };
+
+    // cos and sin of an angle in radians, between 0 and pi.
+    CosSin getCosSin(double angle) const noexcept;
+
+    // 10^(decibels / 20). Anything outside +/-144 dB falls back to std::pow.
+    double getGain(double decibels) const noexcept;
+
+private:
+    DesignTables();
+
+    static constexpr int numAngleSteps = 1024;
+    static constexpr double angleStep = juce::MathConstants<double>::pi / numAngleSteps;
+
+    static constexpr int maxTableDecibels = 144;
+    static constexpr int decibelStepsPerUnit = 8;
+    static constexpr int numGainSteps = 2 * maxTableDecibels * decibelStepsPerUnit;
+
+    std::array<double, numAngleSteps + 1> cosines {}, sines {};
+    std::array<double, numGainSteps + 1> gains {};
+
+    JUCE_DECLARE_NON_COPYABLE (DesignTables)
+};
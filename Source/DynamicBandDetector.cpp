@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    DynamicBandDetector.cpp
+
+  ==============================================================================
+*/
+
+#include "DynamicBandDetector.h"
+
+void DynamicBandDetector::reset() noexcept
+{
+    for (auto* values : { &s1, &s2, &envelope })
+        values->fill(Vec::expand(0.f));
+}
+
+void DynamicBandDetector::setDesigns(const std::array<DynamicBandDesign, maxDynamicBands>& designs) noexcept
+{
+    for (size_t band = 0; band < static_cast<size_t>(maxDynamicBands); ++band)
+    {
+        const auto& design = designs[band];
+        const auto v = band / numLanes;
+        const auto lane = band % numLanes;
+
+        const auto& filter = design.detectorFilter;
+        b0[v].set(lane, static_cast<float>(filter.b0));
+        b1[v].set(lane, static_cast<float>(filter.b1));
+        b2[v].set(lane, static_cast<float>(filter.b2));
+        a1[v].set(lane, static_cast<float>(filter.a1));
+        a2[v].set(lane, static_cast<float>(filter.a2));
+
+        attack[v].set(lane, design.attack);
+        release[v].set(lane, design.release);
+
+        mainWeight[v].set(lane, design.enabled && ! design.useSidechain ? 1.f : 0.f);
+        sidechainWeight[v].set(lane, design.enabled && design.useSidechain ? 1.f : 0.f);
+
+        if (design.enabled && ! enabled[band])
+        {
+            s1[v].set(lane, 0.f);
+            s2[v].set(lane, 0.f);
+            envelope[v].set(lane, 0.f);
+        }
+
+        enabled[band] = design.enabled;
+        staticGainDecibels[band] = design.staticGainDecibels;
+        thresholdDecibels[band] = design.thresholdDecibels;
+
+        // Every decibel over the threshold takes this many off the band's gain, as a compressor's ratio would.
+        slope[band] = 1.f - 1.f / juce::jmax(1.f, design.ratio);
+    }
+}
+
+template <typename SampleType>
+void DynamicBandDetector::process(const juce::dsp::AudioBlock<SampleType>& main, const juce::dsp::AudioBlock<SampleType>& sidechain) noexcept
+{
+    const auto numSamples = main.getNumSamples();
+    jassert(sidechain.getNumSamples() >= numSamples);
+
+    for (size_t start = 0; start < numSamples; start += maxChunkSize)
+    {
+        const auto chunkSize = juce::jmin(maxChunkSize, numSamples - start);
+
+        mixDown(main, start, chunkSize, mainScratch.data());
+        mixDown(sidechain, start, chunkSize, sidechainScratch.data());
+        processChunk(chunkSize);
+    }
+}
+
+template <typename SampleType>
+void DynamicBandDetector::mixDown(const juce::dsp::AudioBlock<SampleType>& block, size_t start, size_t numSamples, float* destination) noexcept
+{
+    const auto numChannels = block.getNumChannels();
+
+    if (numChannels == 0)
+    {
+        std::fill(destination, destination + numSamples, 0.f);
+        return;
+    }
+
+    const auto gain = static_cast<SampleType>(1) / static_cast<SampleType>(numChannels);
+
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        const auto size = static_cast<int>(numSamples);
+
+        juce::FloatVectorOperations::copyWithMultiply(destination, block.getChannelPointer(0) + start, gain, size);
+
+        for (size_t channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::addWithMultiply(destination, block.getChannelPointer(channel) + start, gain, size);
+    }
+    else
+    {
+        // A level detector has no use for the extra precision, so double input is summed and then rounded to float.
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            SampleType sum = 0;
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+                sum += block.getSample(static_cast<int>(channel), static_cast<int>(start + i));
+
+            destination[i] = static_cast<float>(sum * gain);
+        }
+    }
+}
+
+template void DynamicBandDetector::process(const juce::dsp::AudioBlock<float>&, const juce::dsp::AudioBlock<float>&) noexcept;
+template void DynamicBandDetector::process(const juce::dsp::AudioBlock<double>&, const juce::dsp::AudioBlock<double>&) noexcept;
+
+void DynamicBandDetector::processChunk(size_t numSamples) noexcept
+{
+    for (size_t v = 0; v < numVectors; ++v)
+    {
+        // Work on local copies, so the compiler can keep everything in registers for the whole chunk.
+        const auto c0 = b0[v], c1 = b1[v], c2 = b2[v], d1 = a1[v], d2 = a2[v];
+        const auto attackCoefficient = attack[v], releaseCoefficient = release[v];
+        const auto mainGain = mainWeight[v], sidechainGain = sidechainWeight[v];
+
+        auto z1 = s1[v], z2 = s2[v], level = envelope[v];
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto x = mainGain * mainScratch[i] + sidechainGain * sidechainScratch[i];
+
+            const auto y = c0 * x + z1;
+            z1 = c1 * x - d1 * y + z2;
+            z2 = c2 * x - d2 * y;
+
+            // Rising differences are smoothed with the attack coefficient, falling ones with the release.
+            const auto difference = Vec::abs(y) - level;
+            level += attackCoefficient * Vec::max(difference, Vec::expand(0.f))
+                   + releaseCoefficient * Vec::min(difference, Vec::expand(0.f));
+        }
+
+        s1[v] = z1;
+        s2[v] = z2;
+        envelope[v] = level;
+    }
+}
+
+float DynamicBandDetector::getGainDecibels(int band) const noexcept
+{
+    const auto index = static_cast<size_t>(band);
+
+    if (! juce::isPositiveAndBelow(band, maxDynamicBands) || ! enabled[index])
+        return 0.f;
+
+    const auto levelDecibels = juce::Decibels::gainToDecibels(getLane(envelope, band));
+    const auto overshoot = juce::jmax(0.f, levelDecibels - thresholdDecibels[index]);
+
+    // However hard the band is pushed, it never goes past the range of the "Band N Gain" parameters.
+    return juce::jlimit(-24.f, 24.f, staticGainDecibels[index] - overshoot * slope[index]);
+}
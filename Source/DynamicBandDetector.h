@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    DynamicBandDetector.h
+
+    Level detectors for the dynamic EQ bands, all of them running at once,
+    with one band per SIMD lane.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterDesign.h"
+
+/* Each dynamic band listens to its own slice of the spectrum: the input (or the sidechain), mixed down to mono and
+ * band passed around the band's frequency, then rectified and smoothed by a one-pole envelope follower with separate
+ * attack and release. Every band does exactly the same work on the same mono signal, so the bands sit side by side in
+ * the lanes of a juce::dsp::SIMDRegister, and all maxDynamicBands detectors cost about as much as two scalar ones.
+ *
+ * The attack or release choice is made without branching, by splitting the difference between the level and the
+ * envelope into its rising and falling parts. A band that isn't dynamic has both of its input weights at zero, so its
+ * lane just sits at silence.
+ *
+ * The detectors run at the host rate, on the signal before it's filtered; the processor reads each band's gain back
+ * once per chunk and redesigns the band from it.
+ */
+class DynamicBandDetector
+{
+public:
+    // Clears every detector's filter and envelope.
+    void reset() noexcept;
+
+    /* Loads new detector settings. A band that's just been made dynamic starts from silence, while one that already
+     * was carries on from its current envelope, so moving a threshold doesn't make the gain jump. Real-time safe.
+     */
+    void setDesigns(const std::array<DynamicBandDesign, maxDynamicBands>& designs) noexcept;
+
+    /* Runs every detector over a block. The sidechain may be the main block itself, when no sidechain is connected.
+     * Neither block is changed. Blocks can be float or double; either way the detectors themselves run in float.
+     * Real-time safe.
+     */
+    template <typename SampleType>
+    void process(const juce::dsp::AudioBlock<SampleType>& main, const juce::dsp::AudioBlock<SampleType>& sidechain) noexcept;
+
+    // The gain a dynamic band should have right now: its own gain, pulled down by however far it's over the threshold.
+    float getGainDecibels(int band) const noexcept;
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    static constexpr size_t numLanes = Vec::SIMDNumElements;
+    static constexpr size_t numVectors = (static_cast<size_t>(maxDynamicBands) + numLanes - 1) / numLanes;
+
+    // Blocks are mixed down this many samples at a time, into fixed scratch space.
+    static constexpr size_t maxChunkSize = 64;
+
+    // Mixes every channel of a block down to mono.
+    template <typename SampleType>
+    static void mixDown(const juce::dsp::AudioBlock<SampleType>& block, size_t start, size_t numSamples, float* destination) noexcept;
+
+    void processChunk(size_t numSamples) noexcept;
+
+    float getLane(const std::array<Vec, numVectors>& values, int band) const noexcept
+    {
+        return values[static_cast<size_t>(band) / numLanes].get(static_cast<size_t>(band) % numLanes);
+    }
+
+    // The band pass filters, in transposed direct form II, and the envelope followers, one band per lane.
+    std::array<Vec, numVectors> b0 {}, b1 {}, b2 {}, a1 {}, a2 {};
+    std::array<Vec, numVectors> s1 {}, s2 {};
+    std::array<Vec, numVectors> envelope {};
+    std::array<Vec, numVectors> attack {}, release {};
+
+    // How much of the main input and of the sidechain each detector hears; one is 1 and the other 0.
+    std::array<Vec, numVectors> mainWeight {}, sidechainWeight {};
+
+    // The rest of each band's settings, which only matter once a chunk has been run.
+    std::array<bool, maxDynamicBands> enabled {};
+    std::array<float, maxDynamicBands> staticGainDecibels {};
+    std::array<float, maxDynamicBands> thresholdDecibels {};
+    std::array<float, maxDynamicBands> slope {};
+
+    std::array<float, maxChunkSize> mainScratch {}, sidechainScratch {};
+};
@@ -0,0 +1,415 @@
+/*
+  ==============================================================================
+
+    FilterDesign.cpp
+
+  ==============================================================================
+*/
+
+#include "FilterDesign.h"
+#include "DesignTables.h"
+#include "PluginProcessor.h"
+
+namespace CoefficientDesign
+{
+    // Divides everything through by a0, which is how the JUCE coefficient classes store biquads too.
+    static BiquadCoefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2) noexcept
+    {
+        const auto a0Inverse = 1.0 / a0;
+
+        return { b0 * a0Inverse, b1 * a0Inverse, b2 * a0Inverse, a1 * a0Inverse, a2 * a0Inverse };
+    }
+
+    // Keeps a design frequency safely below Nyquist, where the bilinear transform falls apart.
+    static double clampFrequency(double frequency, double sampleRate) noexcept
+    {
+        return juce::jlimit(2.0, sampleRate * 0.49, frequency);
+    }
+
+    /* The gain-dependent halves of the RBJ designs. Everything that depends on the frequency and Q (the trig) is worked
+     * out by the caller, so a dynamic band can change its gain on the audio thread with no more than a gain table
+     * lookup and a sqrt. A is the square root of the linear gain, as in the RBJ cookbook.
+     */
+    static BiquadCoefficients makePeakForGain(double A, double cosOmega, double alpha) noexcept
+    {
+        const auto c2 = -2.0 * cosOmega;
+
+        return normalise(1.0 + alpha * A, c2, 1.0 - alpha * A,
+                         1.0 + alpha / A, c2, 1.0 - alpha / A);
+    }
+
+    // For the shelves, sinOverQ is sin(omega) / Q.
+    static BiquadCoefficients makeLowShelfForGain(double A, double cosOmega, double sinOverQ) noexcept
+    {
+        const auto beta = sinOverQ * std::sqrt(A);
+        const auto aMinus1TimesCos = (A - 1.0) * cosOmega;
+
+        return normalise(A * (A + 1.0 - aMinus1TimesCos + beta),
+                         A * 2.0 * (A - 1.0 - (A + 1.0) * cosOmega),
+                         A * (A + 1.0 - aMinus1TimesCos - beta),
+                         A + 1.0 + aMinus1TimesCos + beta,
+                         -2.0 * (A - 1.0 + (A + 1.0) * cosOmega),
+                         A + 1.0 + aMinus1TimesCos - beta);
+    }
+
+    static BiquadCoefficients makeHighShelfForGain(double A, double cosOmega, double sinOverQ) noexcept
+    {
+        const auto beta = sinOverQ * std::sqrt(A);
+        const auto aMinus1TimesCos = (A - 1.0) * cosOmega;
+
+        return normalise(A * (A + 1.0 + aMinus1TimesCos + beta),
+                         A * -2.0 * (A - 1.0 + (A + 1.0) * cosOmega),
+                         A * (A + 1.0 + aMinus1TimesCos - beta),
+                         A + 1.0 - aMinus1TimesCos + beta,
+                         2.0 * (A - 1.0 - (A + 1.0) * cosOmega),
+                         A + 1.0 - aMinus1TimesCos - beta);
+    }
+
+    /* An RBJ shelf sits at half its gain at the corner frequency. So a low shelf cutting by the full gain, lifted
+     * by half the gain overall, comes out at -gain/2 below the centre, 0 dB at it and +gain/2 above it.
+     * Half the gain in decibels is a linear factor of A, and cutting by the full gain is a shelf with 1 / A.
+     */
+    static BiquadCoefficients makeTiltForGain(double A, double cosOmega, double sinOverQ) noexcept
+    {
+        auto tilt = makeLowShelfForGain(1.0 / A, cosOmega, sinOverQ);
+
+        tilt.b0 *= A;
+        tilt.b1 *= A;
+        tilt.b2 *= A;
+
+        return tilt;
+    }
+
+    // The square root of the linear gain is the gain at half the decibels.
+    static double getSquareRootGain(float gainDecibels) noexcept
+    {
+        return DesignTables::getInstance().getGain(gainDecibels * 0.5);
+    }
+
+    static double getOmega(double sampleRate, float frequency) noexcept
+    {
+        return juce::MathConstants<double>::twoPi * clampFrequency(frequency, sampleRate) / sampleRate;
+    }
+
+    static DesignTables::CosSin getCosSin(double sampleRate, float frequency) noexcept
+    {
+        return DesignTables::getInstance().getCosSin(getOmega(sampleRate, frequency));
+    }
+
+    // 1 / tan(pi f / fs), the bilinear transform's prewarped frequency, as cos / sin of half the angle.
+    static double getPrewarpedCotangent(double sampleRate, float frequency) noexcept
+    {
+        const auto half = DesignTables::getInstance().getCosSin(getOmega(sampleRate, frequency) * 0.5);
+        return half.cos / half.sin;
+    }
+
+    BiquadCoefficients makePeak(double sampleRate, float frequency, float quality, float gainDecibels) noexcept
+    {
+        jassert(sampleRate > 0.0 && quality > 0.0f);
+
+        const auto omega = getCosSin(sampleRate, frequency);
+        return makePeakForGain(getSquareRootGain(gainDecibels), omega.cos, omega.sin / (quality * 2.0));
+    }
+
+    BiquadCoefficients makeHighPass(double sampleRate, float frequency, double quality) noexcept
+    {
+        jassert(sampleRate > 0.0 && quality > 0.0);
+
+        const auto n = getPrewarpedCotangent(sampleRate, frequency);
+        const auto nSquared = n * n;
+        const auto c1 = 1.0 / (1.0 + n / quality + nSquared);
+
+        return { c1 * nSquared,
+                 -2.0 * c1 * nSquared,
+                 c1 * nSquared,
+                 c1 * 2.0 * (1.0 - nSquared),
+                 c1 * (1.0 - n / quality + nSquared) };
+    }
+
+    BiquadCoefficients makeLowPass(double sampleRate, float frequency, double quality) noexcept
+    {
+        jassert(sampleRate > 0.0 && quality > 0.0);
+
+        const auto n = getPrewarpedCotangent(sampleRate, frequency);
+        const auto nSquared = n * n;
+        const auto c1 = 1.0 / (1.0 + n / quality + nSquared);
+
+        return { c1,
+                 c1 * 2.0,
+                 c1,
+                 c1 * 2.0 * (1.0 - nSquared),
+                 c1 * (1.0 - n / quality + nSquared) };
+    }
+
+    BiquadCoefficients makeLowShelf(double sampleRate, float frequency, float quality, float gainDecibels) noexcept
+    {
+        jassert(sampleRate > 0.0 && quality > 0.0f);
+
+        const auto omega = getCosSin(sampleRate, frequency);
+        return makeLowShelfForGain(getSquareRootGain(gainDecibels), omega.cos, omega.sin / quality);
+    }
+
+    BiquadCoefficients makeHighShelf(double sampleRate, float frequency, float quality, float gainDecibels) noexcept
+    {
+        jassert(sampleRate > 0.0 && quality > 0.0f);
+
+        const auto omega = getCosSin(sampleRate, frequency);
+        return makeHighShelfForGain(getSquareRootGain(gainDecibels), omega.cos, omega.sin / quality);
+    }
+
+    BiquadCoefficients makeNotch(double sampleRate, float frequency, float quality) noexcept
+    {
+        jassert(sampleRate > 0.0 && quality > 0.0f);
+
+        const auto n = getPrewarpedCotangent(sampleRate, frequency);
+        const auto nSquared = n * n;
+        const auto c1 = 1.0 / (1.0 + n / quality + nSquared);
+
+        return { c1 * (1.0 + nSquared),
+                 2.0 * c1 * (1.0 - nSquared),
+                 c1 * (1.0 + nSquared),
+                 2.0 * c1 * (1.0 - nSquared),
+                 c1 * (1.0 - n / quality + nSquared) };
+    }
+
+    BiquadCoefficients makeBandPass(double sampleRate, float frequency, float quality) noexcept
+    {
+        jassert(sampleRate > 0.0 && quality > 0.0f);
+
+        const auto n = getPrewarpedCotangent(sampleRate, frequency);
+        const auto nSquared = n * n;
+        const auto c1 = 1.0 / (1.0 + n / quality + nSquared);
+
+        return { c1 * n / quality,
+                 0.0,
+                 -c1 * n / quality,
+                 2.0 * c1 * (1.0 - nSquared),
+                 c1 * (1.0 - n / quality + nSquared) };
+    }
+
+    BiquadCoefficients makeTilt(double sampleRate, float frequency, float quality, float gainDecibels) noexcept
+    {
+        jassert(sampleRate > 0.0 && quality > 0.0f);
+
+        const auto omega = getCosSin(sampleRate, frequency);
+        return makeTiltForGain(getSquareRootGain(gainDecibels), omega.cos, omega.sin / quality);
+    }
+
+    BiquadCoefficients makeBand(double sampleRate, const BandSettings& band) noexcept
+    {
+        /* Gain-based shapes with no gain are exact pass-throughs; returning one lets the engine skip the band.
+         * A dynamic band's gain moves away from its static setting, though, so it has to stay a real filter.
+         */
+        const auto isFlat = band.gainDecibels == 0.f && ! band.dynamic;
+
+        switch (band.type)
+        {
+            case BandType::bell:      return isFlat ? BiquadCoefficients {} : makePeak(sampleRate, band.frequency, band.quality, band.gainDecibels);
+            case BandType::lowShelf:  return isFlat ? BiquadCoefficients {} : makeLowShelf(sampleRate, band.frequency, band.quality, band.gainDecibels);
+            case BandType::highShelf: return isFlat ? BiquadCoefficients {} : makeHighShelf(sampleRate, band.frequency, band.quality, band.gainDecibels);
+            case BandType::tilt:      return isFlat ? BiquadCoefficients {} : makeTilt(sampleRate, band.frequency, band.quality, band.gainDecibels);
+            case BandType::notch:     return makeNotch(sampleRate, band.frequency, band.quality);
+            case BandType::bandPass:  return makeBandPass(sampleRate, band.frequency, band.quality);
+            case BandType::off:       break;
+        }
+
+        return {};
+    }
+
+    DynamicBandDesign makeDynamicBand(double designSampleRate, double hostSampleRate, const BandSettings& band) noexcept
+    {
+        DynamicBandDesign design;
+
+        design.enabled = band.dynamic && (band.type == BandType::bell || band.type == BandType::lowShelf
+                                          || band.type == BandType::highShelf || band.type == BandType::tilt);
+
+        if (! design.enabled)
+            return design;
+
+        const auto omega = getCosSin(designSampleRate, band.frequency);
+
+        design.type = band.type;
+        design.cosOmega = omega.cos;
+        design.sinOverQ = omega.sin / band.quality;
+        design.staticGainDecibels = band.gainDecibels;
+        design.thresholdDecibels = band.thresholdDecibels;
+        design.ratio = juce::jmax(1.f, band.ratio);
+        design.useSidechain = band.useSidechain;
+
+        // The detector hears the same part of the spectrum the band works on.
+        design.detectorFilter = makeBandPass(hostSampleRate, band.frequency, band.quality);
+
+        // The usual one-pole time constants: the envelope covers 1 - 1/e of a step in the given time.
+        auto getSmoothing = [hostSampleRate](float milliseconds)
+        {
+            return static_cast<float>(1.0 - std::exp(-1.0 / (juce::jmax(0.01f, milliseconds) * 0.001 * hostSampleRate)));
+        };
+
+        design.attack = getSmoothing(band.attackMilliseconds);
+        design.release = getSmoothing(band.releaseMilliseconds);
+
+        return design;
+    }
+
+    BiquadCoefficients makeBandForGain(const DynamicBandDesign& design, float gainDecibels) noexcept
+    {
+        const auto A = getSquareRootGain(gainDecibels);
+
+        switch (design.type)
+        {
+            case BandType::bell:      return makePeakForGain(A, design.cosOmega, design.sinOverQ * 0.5);
+            case BandType::lowShelf:  return makeLowShelfForGain(A, design.cosOmega, design.sinOverQ);
+            case BandType::highShelf: return makeHighShelfForGain(A, design.cosOmega, design.sinOverQ);
+            case BandType::tilt:      return makeTiltForGain(A, design.cosOmega, design.sinOverQ);
+            case BandType::off:
+            case BandType::notch:
+            case BandType::bandPass:  break;
+        }
+
+        return {};
+    }
+
+    bool isPassThrough(const BiquadCoefficients& c) noexcept
+    {
+        return c.b0 == 1.0 && c.b1 == 0.0 && c.b2 == 0.0 && c.a1 == 0.0 && c.a2 == 0.0;
+    }
+
+    bool needsDoublePrecision(const BiquadCoefficients& c) noexcept
+    {
+        /* 1 + a1 + a2 is the squared distance of the poles from z = 1, which shrinks with the square of the pole
+         * frequency. Below about 0.5% of the design rate (240 Hz at 48 kHz, 1.9 kHz at 384 kHz), float can no longer
+         * place the poles accurately, and the state's rounding noise is amplified by roughly its inverse.
+         */
+        constexpr auto threshold = 1.0e-3;
+        return ! isPassThrough(c) && 1.0 + c.a1 + c.a2 < threshold;
+    }
+
+    int getNumCutSections(int slopeIndex) noexcept
+    {
+        // 12 dB/Oct is one section, 24 dB/Oct is two, and so on up to 48 dB/Oct. The last choice is 96 dB/Oct.
+        constexpr int sectionsPerSlope[] { 1, 2, 3, 4, 8 };
+        return sectionsPerSlope[juce::jlimit(0, 4, slopeIndex)];
+    }
+
+    /* The Q of each section of an even order Butterworth filter; the poles are spread evenly around
+     * the unit circle, so each section gets a slightly different Q.
+     */
+    static double getButterworthQuality(int section, int numSections) noexcept
+    {
+        const auto order = numSections * 2;
+        return 1.0 / (2.0 * DesignTables::getInstance().getCosSin((2.0 * section + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)).cos);
+    }
+
+    void makeLowCut(double sampleRate, float frequency, int numSections, BiquadCoefficients* destination) noexcept
+    {
+        for (int i = 0; i < numSections; ++i)
+            destination[i] = makeHighPass(sampleRate, frequency, getButterworthQuality(i, numSections));
+    }
+
+    void makeHighCut(double sampleRate, float frequency, int numSections, BiquadCoefficients* destination) noexcept
+    {
+        for (int i = 0; i < numSections; ++i)
+            destination[i] = makeLowPass(sampleRate, frequency, getButterworthQuality(i, numSections));
+    }
+
+    int getOversamplingFactor(int oversamplingIndex) noexcept
+    {
+        return 1 << juce::jlimit(0, 3, oversamplingIndex);
+    }
+
+    ChainCoefficients makeChainCoefficients(const ChainSettings& settings, double hostSampleRate) noexcept
+    {
+        ChainCoefficients coefficients;
+
+        const auto sampleRate = hostSampleRate * getOversamplingFactor(settings.oversampling);
+        coefficients.sampleRate = sampleRate;
+        coefficients.oversamplingFilter = settings.oversamplingFilter;
+
+        coefficients.numLowCutSections  = getNumCutSections(settings.lowCutSlope);
+        coefficients.numHighCutSections = getNumCutSections(settings.highCutSlope);
+
+        // Each filter is designed once, however many channels it ends up on.
+        coefficients.lowCutPlacement  = settings.lowCutPlacement;
+        coefficients.highCutPlacement = settings.highCutPlacement;
+
+        for (int i = 0; i < maxBands; ++i)
+            coefficients.bandPlacements[static_cast<size_t>(i)] = settings.bands[static_cast<size_t>(i)].placement;
+
+        for (int i = 0; i < juce::jmin(settings.numBands, maxBands); ++i)
+            coefficients.bands[static_cast<size_t>(i)] = makeBand(sampleRate, settings.bands[static_cast<size_t>(i)]);
+
+        for (int i = 0; i < maxDynamicBands; ++i)
+            coefficients.dynamics[static_cast<size_t>(i)] = makeDynamicBand(sampleRate, hostSampleRate, settings.bands[static_cast<size_t>(i)]);
+
+        makeLowCut(sampleRate, settings.lowCutFrequency, coefficients.numLowCutSections, coefficients.lowCut.data());
+        makeHighCut(sampleRate, settings.highCutFrequency, coefficients.numHighCutSections, coefficients.highCut.data());
+
+        return coefficients;
+    }
+
+    double getMagnitude(const BiquadCoefficients& c, double omega) noexcept
+    {
+        // Evaluate both polynomials on the unit circle, at z^-1 = e^(-j omega).
+        const auto z1 = std::polar(1.0, -omega);
+        const auto z2 = z1 * z1;
+
+        const auto numerator   = c.b0 + c.b1 * z1 + c.b2 * z2;
+        const auto denominator = 1.0 + c.a1 * z1 + c.a2 * z2;
+
+        return std::abs(numerator) / std::abs(denominator);
+    }
+
+    double getMagnitude(const ChainCoefficients& coefficients, double omega) noexcept
+    {
+        auto magnitude = 1.0;
+
+        for (const auto& band : coefficients.bands)
+            if (! isPassThrough(band))
+                magnitude *= getMagnitude(band, omega);
+
+        for (int i = 0; i < coefficients.numLowCutSections; ++i)
+            magnitude *= getMagnitude(coefficients.lowCut[static_cast<size_t>(i)], omega);
+
+        for (int i = 0; i < coefficients.numHighCutSections; ++i)
+            magnitude *= getMagnitude(coefficients.highCut[static_cast<size_t>(i)], omega);
+
+        return magnitude;
+    }
+
+    // The largest pole radius of one section; the poles are the roots of z^2 + a1 z + a2.
+    static double getPoleRadius(const BiquadCoefficients& c) noexcept
+    {
+        const auto a1 = c.a1;
+        const auto a2 = c.a2;
+        const auto discriminant = a1 * a1 - 4.0 * a2;
+
+        // A complex conjugate pair sits at radius sqrt(a2); two real poles have to be checked separately.
+        if (discriminant < 0.0)
+            return std::sqrt(a2);
+
+        const auto root = std::sqrt(discriminant);
+        return juce::jmax(std::abs(-a1 + root), std::abs(-a1 - root)) * 0.5;
+    }
+
+    double getDecayTimeSeconds(const ChainCoefficients& coefficients) noexcept
+    {
+        jassert(coefficients.sampleRate > 0.0);
+
+        auto radius = 0.0;
+
+        for (const auto& band : coefficients.bands)
+            radius = juce::jmax(radius, getPoleRadius(band));
+
+        for (int i = 0; i < coefficients.numLowCutSections; ++i)
+            radius = juce::jmax(radius, getPoleRadius(coefficients.lowCut[static_cast<size_t>(i)]));
+
+        for (int i = 0; i < coefficients.numHighCutSections; ++i)
+            radius = juce::jmax(radius, getPoleRadius(coefficients.highCut[static_cast<size_t>(i)]));
+
+        // Every design here is stable, but rounding can leave a pole a hair away from the unit circle.
+        radius = juce::jlimit(1.0e-6, 0.999999, radius);
+
+        // The envelope of each pole's contribution shrinks by a factor of radius every sample; -100 dB is 1e-5.
+        return std::log(1.0e-5) / std::log(radius) / coefficients.sampleRate;
+    }
+}
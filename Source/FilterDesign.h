@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    FilterDesign.h
+
+    Allocation-free coefficient design for the EQ chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct ChainSettings;
+struct BandSettings;
+enum class BandType;
+
+/* A set of normalised biquad coefficients (a0 is always 1, so it isn't stored).
+ * JUCE's juce::dsp::IIR::Coefficients objects are reference-counted and own a juce::Array on the heap,
+ * so every makePeakFilter() call allocates. These are plain values instead, which means we can copy
+ * them around between threads and into preallocated storage without ever touching the allocator.
+ *
+ * They're kept in double, which is what the designs are worked out in. The float engine rounds them as it loads
+ * them; the double one, and the mixed precision stages, need every bit for low cuts and bands near DC.
+ */
+struct BiquadCoefficients
+{
+    double b0 { 1.0 };
+    double b1 { 0.0 };
+    double b2 { 0.0 };
+    double a1 { 0.0 };
+    double a2 { 0.0 };
+};
+
+/* One second order section per 12 dB/Oct, so 48 dB/Oct needs four of them.
+ * The steepest slope on offer is 96 dB/Oct, which needs eight.
+ */
+constexpr int maxCutSections = 8;
+
+/* The parametric bands between the cuts. "Band Count" shows between minBands and maxBands of them, but the storage
+ * for all maxBands is always there, so changing the count never allocates anything.
+ */
+constexpr int minBands = 8;
+constexpr int maxBands = 24;
+
+/* The first few bands can also act as dynamic EQs. There are always at least minBands bands, so a dynamic band is never
+ * past the band count.
+ */
+constexpr int maxDynamicBands = minBands;
+
+/* Which channels a filter runs on. The "Channel Mode" splits a bus into two groups of channels: left and right, mid
+ * and side, or the front and the rear of a surround bus. A filter can run on all of them, or on either group alone.
+ * With the channels linked, every filter runs on every channel whatever its placement.
+ */
+enum class ChannelPlacement
+{
+    all,
+    firstGroup,
+    secondGroup
+};
+
+/* Everything the audio thread needs to run one dynamic band, worked out in advance by the coefficient pipeline.
+ * The band's trig terms are kept so the audio thread can redesign it for a new gain without any trig of its own,
+ * and the detector settings are already in the form the envelope followers use.
+ */
+struct DynamicBandDesign
+{
+    bool enabled { false };
+    BandType type {};
+
+    // cos(omega) and sin(omega) / Q at the chain's design rate.
+    double cosOmega { 1.0 };
+    double sinOverQ { 0.0 };
+
+    float staticGainDecibels { 0.f };
+    float thresholdDecibels { 0.f };
+    float ratio { 1.f };
+
+    // One-pole smoothing coefficients per host sample, and a band pass around the band, at the host rate.
+    float attack { 1.f };
+    float release { 1.f };
+    BiquadCoefficients detectorFilter;
+
+    // Whether the detector listens to the sidechain bus rather than the main input.
+    bool useSidechain { false };
+};
+
+// Every coefficient the chain needs, in one fixed-size block so it can live in a preallocated slot.
+struct ChainCoefficients
+{
+    std::array<BiquadCoefficients, maxCutSections> lowCut;
+    std::array<BiquadCoefficients, maxCutSections> highCut;
+
+    // Bands that are switched off, flat, or beyond the band count are left as pass-throughs, and cost nothing.
+    std::array<BiquadCoefficients, maxBands> bands;
+
+    // How many of the cut sections are in use; the rest are bypassed.
+    int numLowCutSections { 1 };
+    int numHighCutSections { 1 };
+
+    // The rate the set was designed for, which is higher than the host's when oversampling is on.
+    double sampleRate { 0.0 };
+
+    /* The "Oversampling Filter" choice the set goes with. The audio thread picks its oversampler from this rather
+     * than from the parameter, so it only ever asks for one the coefficient pipeline has made sure exists.
+     */
+    int oversamplingFilter { 0 };
+
+    // The dynamic settings of the first maxDynamicBands bands. These aren't ramped; they take effect straight away.
+    std::array<DynamicBandDesign, maxDynamicBands> dynamics;
+
+    // Which channels each filter runs on. Nor are these; a filter moves from one group of channels to another at once.
+    ChannelPlacement lowCutPlacement { ChannelPlacement::all };
+    ChannelPlacement highCutPlacement { ChannelPlacement::all };
+    std::array<ChannelPlacement, maxBands> bandPlacements {};
+};
+
+/* These mirror the formulas used by juce::dsp::IIR::Coefficients and juce::dsp::FilterDesign,
+ * but write into values we already own. None of them allocate or lock, so they are safe to call from any thread.
+ */
+namespace CoefficientDesign
+{
+    // The same RBJ peak filter as IIR::Coefficients::makePeakFilter(); the gain is given in decibels.
+    BiquadCoefficients makePeak(double sampleRate, float frequency, float quality, float gainDecibels) noexcept;
+
+    BiquadCoefficients makeHighPass(double sampleRate, float frequency, double quality) noexcept;
+    BiquadCoefficients makeLowPass(double sampleRate, float frequency, double quality) noexcept;
+
+    // The RBJ shelves, notch and constant 0 dB peak band pass, as in IIR::Coefficients.
+    BiquadCoefficients makeLowShelf(double sampleRate, float frequency, float quality, float gainDecibels) noexcept;
+    BiquadCoefficients makeHighShelf(double sampleRate, float frequency, float quality, float gainDecibels) noexcept;
+    BiquadCoefficients makeNotch(double sampleRate, float frequency, float quality) noexcept;
+    BiquadCoefficients makeBandPass(double sampleRate, float frequency, float quality) noexcept;
+
+    /* A tilt around a centre frequency: half the gain is taken off below it and added above it, so a positive gain
+     * brightens and a negative one darkens, while the centre itself stays put.
+     */
+    BiquadCoefficients makeTilt(double sampleRate, float frequency, float quality, float gainDecibels) noexcept;
+
+    /* Designs one parametric band. A band that's off, or a bell, shelf or tilt with no gain, comes back as an exact
+     * pass-through, which the filter engine recognises and skips.
+     */
+    BiquadCoefficients makeBand(double sampleRate, const BandSettings& band) noexcept;
+
+    /* Works out the dynamic side of a band, with the band itself designed at designSampleRate and its detector
+     * running at hostSampleRate. Only bells, shelves and tilts can be dynamic; anything else comes back disabled.
+     */
+    DynamicBandDesign makeDynamicBand(double designSampleRate, double hostSampleRate, const BandSettings& band) noexcept;
+
+    /* Redesigns a dynamic band for a new gain, from its precomputed trig terms. Real-time safe, and cheap enough to
+     * run for every dynamic band on every sub-block. Unlike makeBand(), a flat band isn't turned into a pass-through,
+     * so a dynamic band stays in the filter engine's active list as its gain moves through 0 dB.
+     */
+    BiquadCoefficients makeBandForGain(const DynamicBandDesign& design, float gainDecibels) noexcept;
+
+    // Whether a section is an exact pass-through.
+    bool isPassThrough(const BiquadCoefficients& coefficients) noexcept;
+
+    /* Whether a section's poles sit so close to DC that float coefficients and state can't do it justice.
+     * In mixed precision these sections run in double, while everything else stays in float.
+     */
+    bool needsDoublePrecision(const BiquadCoefficients& coefficients) noexcept;
+
+    // Maps a LowCut / HighCut Slope choice index onto the number of second order sections it needs.
+    int getNumCutSections(int slopeIndex) noexcept;
+
+    /* Butterworth cascades, equivalent to FilterDesign::designIIRHighpassHighOrderButterworthMethod()
+     * with an order of 2 * numSections. The destination must have room for numSections sets.
+     */
+    void makeLowCut(double sampleRate, float frequency, int numSections, BiquadCoefficients* destination) noexcept;
+    void makeHighCut(double sampleRate, float frequency, int numSections, BiquadCoefficients* destination) noexcept;
+
+    // Maps an Oversampling choice index onto the oversampling factor: 1, 2, 4 or 8.
+    int getOversamplingFactor(int oversamplingIndex) noexcept;
+
+    /* Designs the whole chain from a settings snapshot. The sample rate is the host's; when the settings ask for
+     * oversampling, the chain is designed for the oversampled rate.
+     */
+    ChainCoefficients makeChainCoefficients(const ChainSettings& settings, double sampleRate) noexcept;
+
+    // The linear gain of a single section at omega radians per sample.
+    double getMagnitude(const BiquadCoefficients& coefficients, double omega) noexcept;
+
+    // The linear gain of every section in use, multiplied together.
+    double getMagnitude(const ChainCoefficients& coefficients, double omega) noexcept;
+
+    /* How long the chain's impulse response takes to die away by 100 dB, judged from its slowest pole.
+     * Low cuts with steep slopes and narrow low bells ring for the longest.
+     */
+    double getDecayTimeSeconds(const ChainCoefficients& coefficients) noexcept;
+}
@@ -0,0 +1,351 @@
+/*
+  ==============================================================================
+
+    LinearPhaseConvolver.cpp
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseConvolver.h"
+
+namespace
+{
+    // juce::dsp::FFT takes its size as a power of two.
+    int getFFTOrder(int size) noexcept
+    {
+        return juce::roundToInt(std::log2(static_cast<double>(size)));
+    }
+}
+
+LinearPhaseConvolver::LinearPhaseConvolver()
+{
+}
+
+LinearPhaseConvolver::~LinearPhaseConvolver()
+{
+    sharedResources->removeWorker(*this);
+}
+
+int LinearPhaseConvolver::getKernelLength(double sampleRate) noexcept
+{
+    // About 6 Hz per bin, which is enough to get a low cut at 20 Hz right.
+    return juce::jlimit(4096, 65536, juce::nextPowerOfTwo(juce::roundToInt(sampleRate / 6.0)));
+}
+
+void LinearPhaseConvolver::prepare(int newNumChannels, double newSampleRate)
+{
+    const juce::ScopedLock sl(allocateLock);
+
+    sharedResources->removeWorker(*this);
+    ready = false;
+
+    numChannels = newNumChannels;
+    sampleRate = newSampleRate;
+    kernelLength = getKernelLength(sampleRate);
+    partitionSize = kernelLength / numPartitions;
+    numBins = partitionSize + 1;
+
+    // Whatever was allocated for the old settings is the wrong size now; allocate() starts again from scratch.
+    partitionFFT.reset();
+    designPartitionFFT = kernelFFT = nullptr;
+
+    auto freeBuffer = [](std::vector<float>& buffer)
+    {
+        buffer.clear();
+        buffer.shrink_to_fit();
+    };
+
+    for (auto* buffer : { &designBuffer, &fftBuffer, &fadeBuffer })
+        freeBuffer(*buffer);
+
+    for (auto& kernel : kernels)
+        freeBuffer(kernel);
+
+    channels.clear();
+}
+
+void LinearPhaseConvolver::allocate(const ChainCoefficients& coefficients)
+{
+    const juce::ScopedLock sl(allocateLock);
+
+    if (ready.load() || kernelLength == 0)
+        return;
+
+    const auto fftSize = partitionSize * 2;
+    const auto spectrumSize = static_cast<size_t>(numBins * 2);
+
+    partitionFFT = std::make_unique<juce::dsp::FFT>(getFFTOrder(fftSize));
+    designPartitionFFT = &sharedResources->getFFT(getFFTOrder(fftSize));
+    kernelFFT = &sharedResources->getFFT(getFFTOrder(kernelLength));
+
+    for (auto& kernel : kernels)
+        kernel.assign(numPartitions * spectrumSize, 0.f);
+
+    // JUCE's real-only transforms work in place on a buffer twice the FFT size.
+    designBuffer.assign(static_cast<size_t>(kernelLength * 2), 0.f);
+    fftBuffer.assign(static_cast<size_t>(fftSize * 2), 0.f);
+    fadeBuffer.assign(static_cast<size_t>(fftSize * 2), 0.f);
+
+    channels.resize(static_cast<size_t>(numChannels));
+
+    for (auto& channel : channels)
+    {
+        channel.input.assign(static_cast<size_t>(fftSize), 0.f);
+        channel.output.assign(static_cast<size_t>(partitionSize), 0.f);
+        channel.history.assign(numPartitions * spectrumSize, 0.f);
+    }
+
+    // Slot 0 is the first kernel; the rest start out free.
+    readyKernels.reset();
+    freeKernels.reset();
+
+    for (int i = 1; i < numSlots; ++i)
+        freeKernels.push(i);
+
+    currentKernel = 0;
+    fadingFromKernel = -1;
+    workerKernel = -1;
+    designKernel(coefficients, currentKernel);
+
+    // Anything asked for before now is covered by the kernel we just designed.
+    {
+        const juce::ScopedLock requestScope(requestLock);
+        hasRequest = false;
+    }
+
+    reset();
+    ready.store(true, std::memory_order_release);
+    sharedResources->addWorker(*this);
+}
+
+void LinearPhaseConvolver::release()
+{
+    sharedResources->removeWorker(*this);
+}
+
+void LinearPhaseConvolver::requestKernel(const ChainCoefficients& coefficients)
+{
+    if (! isReady())
+        return;
+
+    const juce::ScopedLock sl(requestLock);
+    requestedCoefficients = coefficients;
+    hasRequest = true;
+}
+
+void LinearPhaseConvolver::reset() noexcept
+{
+    for (auto& channel : channels)
+    {
+        std::fill(channel.input.begin(), channel.input.end(), 0.f);
+        std::fill(channel.output.begin(), channel.output.end(), 0.f);
+        std::fill(channel.history.begin(), channel.history.end(), 0.f);
+    }
+
+    historyPosition = 0;
+    bufferPosition = 0;
+}
+
+bool LinearPhaseConvolver::hasWork()
+{
+    const juce::ScopedLock sl(requestLock);
+    return hasRequest;
+}
+
+void LinearPhaseConvolver::doWork()
+{
+    // The audio thread hands slots back as soon as it's finished crossfading, so if none is free, one will be next time.
+    if (workerKernel < 0 && ! freeKernels.pop(workerKernel))
+        return;
+
+    ChainCoefficients coefficients;
+    bool hasWork = false;
+
+    {
+        const juce::ScopedLock sl(requestLock);
+        std::swap(hasWork, hasRequest);
+        coefficients = requestedCoefficients;
+    }
+
+    if (! hasWork)
+        return;
+
+    designKernel(coefficients, workerKernel);
+
+    // The kernel slots circulate like the pipeline's coefficient slots, so this can't fail either; see IndexQueue.
+    const auto pushed = readyKernels.push(workerKernel);
+    jassert(pushed);
+    juce::ignoreUnused(pushed);
+    workerKernel = -1;
+}
+
+void LinearPhaseConvolver::designKernel(const ChainCoefficients& coefficients, int slot)
+{
+    auto* impulse = designBuffer.data();
+    std::fill(designBuffer.begin(), designBuffer.end(), 0.f);
+
+    /* Sample the magnitude of the chain at every bin, with zero phase. Flipping the sign of every other bin is a delay
+     * of half the kernel length, which moves the (symmetric) impulse from the wrapped-around start into the middle.
+     * The chain may have been designed for an oversampled rate, in which case our bins sit lower down its response.
+     */
+    const auto rateRatio = coefficients.sampleRate > 0.0 ? coefficients.sampleRate / sampleRate : 1.0;
+
+    for (int k = 0; k <= kernelLength / 2; ++k)
+    {
+        const auto omega = juce::MathConstants<double>::twoPi * k / (kernelLength * rateRatio);
+        const auto magnitude = CoefficientDesign::getMagnitude(coefficients, omega);
+
+        impulse[2 * k] = static_cast<float>((k & 1) != 0 ? -magnitude : magnitude);
+    }
+
+    kernelFFT->performRealOnlyInverseTransform(impulse);
+
+    // A Blackman window, centred on the middle tap, tames the ripple from truncating the response.
+    for (int n = 0; n < kernelLength; ++n)
+    {
+        const auto phase = juce::MathConstants<double>::twoPi * n / kernelLength;
+        impulse[n] *= static_cast<float>(0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase));
+    }
+
+    // Each partition is zero padded to the FFT size and transformed. The second half of designBuffer is free by now.
+    auto* scratch = designBuffer.data() + kernelLength;
+    const auto spectrumSize = numBins * 2;
+    auto* destination = kernels[static_cast<size_t>(slot)].data();
+
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        std::fill(scratch, scratch + partitionSize * 4, 0.f);
+        std::copy(impulse + p * partitionSize, impulse + (p + 1) * partitionSize, scratch);
+
+        designPartitionFFT->performRealOnlyForwardTransform(scratch, true);
+        std::copy(scratch, scratch + spectrumSize, destination + p * spectrumSize);
+    }
+}
+
+template <typename SampleType>
+void LinearPhaseConvolver::process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    jassert(static_cast<int>(block.getNumChannels()) <= numChannels);
+
+    const auto numSamples = block.getNumSamples();
+    const auto numChannelsToProcess = juce::jmin(static_cast<int>(block.getNumChannels()), numChannels);
+
+    // Gather input a partition at a time, handing out the output computed at the end of the previous partition.
+    for (size_t done = 0; done < numSamples;)
+    {
+        const auto numThisTime = juce::jmin(numSamples - done, static_cast<size_t>(partitionSize - bufferPosition));
+
+        for (int i = 0; i < numChannelsToProcess; ++i)
+        {
+            auto* data = block.getChannelPointer(static_cast<size_t>(i)) + done;
+            auto& channel = channels[static_cast<size_t>(i)];
+
+            std::copy(data, data + numThisTime, channel.input.data() + partitionSize + bufferPosition);
+            std::copy(channel.output.data() + bufferPosition, channel.output.data() + bufferPosition + numThisTime, data);
+        }
+
+        bufferPosition += static_cast<int>(numThisTime);
+        done += numThisTime;
+
+        if (bufferPosition == partitionSize)
+        {
+            processPartition(numChannelsToProcess);
+            bufferPosition = 0;
+        }
+    }
+}
+
+template void LinearPhaseConvolver::process(const juce::dsp::AudioBlock<float>&) noexcept;
+template void LinearPhaseConvolver::process(const juce::dsp::AudioBlock<double>&) noexcept;
+
+void LinearPhaseConvolver::pullLatestKernel() noexcept
+{
+    // Skip over any kernels that have already been superseded.
+    int newest = -1, index = -1;
+
+    while (readyKernels.pop(index))
+    {
+        if (newest >= 0)
+            freeKernels.push(newest);
+
+        newest = index;
+    }
+
+    if (newest >= 0)
+    {
+        fadingFromKernel = currentKernel;
+        currentKernel = newest;
+    }
+}
+
+void LinearPhaseConvolver::accumulate(const float* history, const float* kernel, float* destination) const noexcept
+{
+    const auto spectrumSize = numBins * 2;
+    std::fill(destination, destination + partitionSize * 4, 0.f);
+
+    // The newest input spectrum meets the first partition of the kernel, the one before it the second, and so on.
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto* x = history + ((historyPosition + p) % numPartitions) * spectrumSize;
+        const auto* h = kernel + p * spectrumSize;
+
+        for (int k = 0; k < spectrumSize; k += 2)
+        {
+            destination[k]     += x[k] * h[k]     - x[k + 1] * h[k + 1];
+            destination[k + 1] += x[k] * h[k + 1] + x[k + 1] * h[k];
+        }
+    }
+}
+
+void LinearPhaseConvolver::processPartition(int numChannelsToProcess) noexcept
+{
+    pullLatestKernel();
+
+    const auto spectrumSize = numBins * 2;
+    historyPosition = (historyPosition + numPartitions - 1) % numPartitions;
+
+    for (int i = 0; i < numChannelsToProcess; ++i)
+    {
+        auto& channel = channels[static_cast<size_t>(i)];
+
+        // Transform the last two partitions of input, and push the spectrum onto the delay line.
+        std::copy(channel.input.begin(), channel.input.end(), fftBuffer.begin());
+        std::fill(fftBuffer.begin() + partitionSize * 2, fftBuffer.end(), 0.f);
+        partitionFFT->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+        std::copy(fftBuffer.data(), fftBuffer.data() + spectrumSize, channel.history.data() + historyPosition * spectrumSize);
+
+        // Overlap-save: the second half of the inverse transform is free of wrap-around, and is our output.
+        accumulate(channel.history.data(), kernels[static_cast<size_t>(currentKernel)].data(), fftBuffer.data());
+        partitionFFT->performRealOnlyInverseTransform(fftBuffer.data());
+
+        const auto* newOutput = fftBuffer.data() + partitionSize;
+
+        if (fadingFromKernel >= 0)
+        {
+            accumulate(channel.history.data(), kernels[static_cast<size_t>(fadingFromKernel)].data(), fadeBuffer.data());
+            partitionFFT->performRealOnlyInverseTransform(fadeBuffer.data());
+
+            const auto* oldOutput = fadeBuffer.data() + partitionSize;
+
+            for (int n = 0; n < partitionSize; ++n)
+            {
+                const auto amount = static_cast<float>(n + 1) / static_cast<float>(partitionSize);
+                channel.output[static_cast<size_t>(n)] = oldOutput[n] + amount * (newOutput[n] - oldOutput[n]);
+            }
+        }
+        else
+        {
+            std::copy(newOutput, newOutput + partitionSize, channel.output.begin());
+        }
+
+        // The partition we just gathered becomes the previous one.
+        std::copy(channel.input.begin() + partitionSize, channel.input.end(), channel.input.begin());
+    }
+
+    if (fadingFromKernel >= 0)
+    {
+        freeKernels.push(fadingFromKernel);
+        fadingFromKernel = -1;
+    }
+}
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    LinearPhaseConvolver.h
+
+    Runs the EQ curve as a linear phase FIR, using uniformly partitioned
+    FFT convolution.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientPipeline.h"
+#include "FilterDesign.h"
+#include "SharedResources.h"
+
+/* The IIR chain is minimum phase: every frequency comes out with a different delay. For linear phase we take the
+ * magnitude response of the same chain, and build a symmetric FIR with exactly that magnitude and a constant delay
+ * of half its length. The kernel length scales with the sample rate to give the same resolution at the low end,
+ * which makes it 8192 taps at 44.1/48 kHz and 65536 taps at 384 kHz.
+ *
+ * Kernels that long are far too expensive to run directly, so they're cut into equal partitions and convolved in the
+ * frequency domain (uniformly partitioned overlap-save). Every partitionSize samples, each channel costs one forward
+ * FFT, one inverse FFT and a complex multiply-add per partition. The partition size grows with the kernel so the
+ * partition count stays at 32, which keeps the cost per sample flat whatever the kernel length.
+ *
+ * Kernels are designed on the shared worker pool into preallocated slots and handed over through lock-free queues,
+ * the same way CoefficientPipeline hands over biquad coefficients. When a new kernel arrives, the next partition
+ * is run through both the old and the new kernel and crossfaded, so changes are click-free. The input spectra are
+ * shared between the two, so a crossfade only costs an extra multiply-add pass and inverse FFT.
+ *
+ * The latency is half the kernel length, plus one partition for gathering the input.
+ */
+class LinearPhaseConvolver  : private SharedResources::Worker
+{
+public:
+    LinearPhaseConvolver();
+    ~LinearPhaseConvolver() override;
+
+    /* Called from prepareToPlay(). Works out the kernel and partition sizes for the sample rate, which is all
+     * getLatencySamples() needs, and drops anything allocated for the old settings. It's cheap, so an instance that
+     * never goes into linear phase mode never pays for the convolver.
+     */
+    void prepare(int numChannels, double sampleRate);
+
+    /* Allocates everything, designs a first kernel from these coefficients and starts the background work, unless
+     * that's already been done since prepare(). Not real-time safe; call it from prepareToPlay() or the coefficient
+     * pipeline's worker, once linear phase is actually wanted.
+     */
+    void allocate(const ChainCoefficients& coefficients);
+
+    // Whether allocate() has finished, so process() can be called. Real-time safe.
+    bool isReady() const noexcept   { return ready.load(std::memory_order_acquire); }
+
+    // Stops the background work.
+    void release();
+
+    /* Asks the worker for a kernel matching these coefficients. Only the newest request counts, and requests made
+     * before allocate() are dropped, since allocate() designs its own. Call it from any thread but the audio thread.
+     */
+    void requestKernel(const ChainCoefficients& coefficients);
+
+    // Clears the convolution history. Real-time safe.
+    void reset() noexcept;
+
+    /* Filters the block in place. It must not have more channels than were passed to prepare().
+     * Double blocks are filtered too, though the convolution itself is always done in float.
+     */
+    template <typename SampleType>
+    void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    int getLatencySamples() const noexcept   { return partitionSize + kernelLength / 2; }
+
+    // How long the output rings on after the input stops, not counting the latency.
+    double getTailLengthSeconds() const noexcept   { return sampleRate > 0.0 ? kernelLength / (2.0 * sampleRate) : 0.0; }
+
+    // The kernel length for a sample rate, in taps.
+    static int getKernelLength(double sampleRate) noexcept;
+
+private:
+    bool hasWork() override;
+    void doWork() override;
+
+    // Fills a kernel slot with the partition spectra of a new FIR. Worker (or prepare()) only.
+    void designKernel(const ChainCoefficients& coefficients, int slot);
+
+    // Picks up the newest kernel, if there is one and no crossfade is running.
+    void pullLatestKernel() noexcept;
+
+    // Runs every channel through one partition's worth of convolution.
+    void processPartition(int numChannelsToProcess) noexcept;
+
+    // Sums the history spectra multiplied by a kernel's partition spectra into destination.
+    void accumulate(const float* history, const float* kernel, float* destination) const noexcept;
+
+    static constexpr int numPartitions = 32;
+    static constexpr int numSlots = 4;
+
+    int kernelLength { 0 };
+    int partitionSize { 0 };
+
+    // Complex bins per partition spectrum; the FFT is twice the partition size, and we keep the non-negative half.
+    int numBins { 0 };
+
+    int numChannels { 0 };
+    double sampleRate { 0.0 };
+
+    // Set once allocate() has run for the current settings. allocate() holds allocateLock throughout.
+    std::atomic<bool> ready { false };
+    juce::CriticalSection allocateLock;
+
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+
+    /* The audio thread has an FFT of its own. The worker's are shared with every other instance at the same rate,
+     * since kernels are only designed now and then.
+     */
+    std::unique_ptr<juce::dsp::FFT> partitionFFT;
+    const juce::dsp::FFT* designPartitionFFT { nullptr };
+    const juce::dsp::FFT* kernelFFT { nullptr };
+
+    // Each slot holds numPartitions spectra of numBins interleaved complex values.
+    std::array<std::vector<float>, numSlots> kernels;
+    IndexQueue<numSlots> readyKernels, freeKernels;
+
+    // The worker keeps hold of one free slot between requests, so it can start designing as soon as one arrives.
+    int workerKernel { -1 };
+
+    // Audio thread only. fadingFromKernel is -1 unless a crossfade is due on the next partition.
+    int currentKernel { 0 };
+    int fadingFromKernel { -1 };
+
+    juce::CriticalSection requestLock;
+    ChainCoefficients requestedCoefficients;
+    bool hasRequest { false };
+
+    // Worker scratch, big enough for the kernel-length FFT.
+    std::vector<float> designBuffer;
+
+    struct Channel
+    {
+        // The previous partition followed by the one being gathered.
+        std::vector<float> input;
+
+        // The output for the partition being gathered, computed at the end of the previous one.
+        std::vector<float> output;
+
+        // A frequency domain delay line of the last numPartitions input spectra.
+        std::vector<float> history;
+    };
+
+    std::vector<Channel> channels;
+
+    // Where the newest spectrum lives in each channel's history, and how far into the current partition we are.
+    int historyPosition { 0 };
+    int bufferPosition { 0 };
+
+    // Audio thread scratch for the FFTs and the outgoing kernel's output during a crossfade.
+    std::vector<float> fftBuffer, fadeBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LinearPhaseConvolver)
+};
@@ -0,0 +1,792 @@
+/*
+  ==============================================================================
+
+    MultichannelBiquadCascade.cpp
+
+  ==============================================================================
+*/
+
+#include "MultichannelBiquadCascade.h"
+
+namespace
+{
+    /* Where the k-th stage of a cascade with numLowCutSections low cut sections lives.
+     * The low cut sections come first, then the high cut sections.
+     */
+    template <int MaxCutSections>
+    constexpr int getStagePosition(int numLowCutSections, int k) noexcept
+    {
+        return k < numLowCutSections ? k : MaxCutSections + (k - numLowCutSections);
+    }
+
+    // One biquad tick, in whichever form the stage is.
+    template <typename Vec, typename Stage, typename State>
+    forcedinline Vec processStage(Vec x, const Stage& c, State& s) noexcept
+    {
+        if constexpr (Stage::isStateVariable)
+        {
+            // The trapezoidal state variable filter; s1 and s2 are the band pass and low pass integrators.
+            const auto v3 = x - s.s2;
+            const auto v1 = c.g1 * s.s1 + c.g2 * v3;
+            const auto v2 = s.s2 + c.g2 * s.s1 + c.g3 * v3;
+            s.s1 = v1 + v1 - s.s1;
+            s.s2 = v2 + v2 - s.s2;
+            return c.m0 * x + c.m1 * v1 + c.m2 * v2;
+        }
+        else
+        {
+            // Transposed direct form II.
+            const auto y = c.b0 * x + s.s1;
+            s.s1 = c.b1 * x - c.a1 * y + s.s2;
+            s.s2 = c.b2 * x - c.a2 * y;
+            return y;
+        }
+    }
+
+    template <int NumLowCutSections, typename Vec, typename Stage, typename State, size_t... K>
+    void processCascadeImpl(Vec* samples, size_t numSamples, const Stage* stages, State* states, Vec offset,
+                            std::index_sequence<K...>) noexcept
+    {
+        // Local copies, so the compiler is free to keep everything in registers for the whole loop.
+        const Stage c[] { stages[getStagePosition<maxCutSections>(NumLowCutSections, static_cast<int>(K))]... };
+        State s[] { states[getStagePosition<maxCutSections>(NumLowCutSections, static_cast<int>(K))]... };
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            // The denormal offset goes in at the top, and again after the last low cut section, which blocks it.
+            auto x = samples[i] + offset;
+            ((x = processStage(x, c[K], s[K]), x = (K + 1 == NumLowCutSections ? x + offset : x)), ...);
+            samples[i] = x;
+        }
+
+        ((states[getStagePosition<maxCutSections>(NumLowCutSections, static_cast<int>(K))] = s[K]), ...);
+    }
+}
+
+template <typename SampleType>
+template <int NumLowCutSections, int NumHighCutSections, typename StageType>
+void MultichannelBiquadCascade<SampleType>::processCascade(Vec* samples, size_t numSamples, const StageType* stageCoefficients, State* stageStates) noexcept
+{
+    static_assert(NumLowCutSections <= maxCutSections && NumHighCutSections <= maxCutSections);
+
+    processCascadeImpl<NumLowCutSections>(samples, numSamples, stageCoefficients, stageStates, Vec::expand(antiDenormal),
+                                          std::make_index_sequence<static_cast<size_t>(NumLowCutSections + NumHighCutSections)>());
+}
+
+template <typename SampleType>
+template <int NumBands>
+void MultichannelBiquadCascade<SampleType>::processBands(Vec* samples, size_t numSamples, const BandCoefficients& c,
+                                                         BandStates& bandState, const int* bandIndices) noexcept
+{
+    // Gather this pass's bands out of the arrays into locals, so they can live in registers for the whole loop.
+    Vec b0[NumBands], b1[NumBands], b2[NumBands], a1[NumBands], a2[NumBands], s1[NumBands], s2[NumBands];
+
+    for (int k = 0; k < NumBands; ++k)
+    {
+        const auto band = static_cast<size_t>(bandIndices[k]);
+        b0[k] = c.b0[band];
+        b1[k] = c.b1[band];
+        b2[k] = c.b2[band];
+        a1[k] = c.a1[band];
+        a2[k] = c.a2[band];
+        s1[k] = bandState.s1[band];
+        s2[k] = bandState.s2[band];
+    }
+
+    const auto offset = Vec::expand(antiDenormal);
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        auto x = samples[i] + offset;
+
+        // The same transposed direct form II tick as the cuts; NumBands is a constant, so this is fully unrolled.
+        for (int k = 0; k < NumBands; ++k)
+        {
+            const auto y = b0[k] * x + s1[k];
+            s1[k] = b1[k] * x - a1[k] * y + s2[k];
+            s2[k] = b2[k] * x - a2[k] * y;
+            x = y;
+        }
+
+        samples[i] = x;
+    }
+
+    for (int k = 0; k < NumBands; ++k)
+    {
+        const auto band = static_cast<size_t>(bandIndices[k]);
+        bandState.s1[band] = s1[k];
+        bandState.s2[band] = s2[k];
+    }
+}
+
+template <typename SampleType>
+const std::array<typename MultichannelBiquadCascade<SampleType>::BandKernel,
+                 MultichannelBiquadCascade<SampleType>::maxBandsPerPass> MultichannelBiquadCascade<SampleType>::bandKernels
+{{
+    &processBands<1>, &processBands<2>, &processBands<3>, &processBands<4>
+}};
+
+template <typename SampleType>
+template <int NumBands>
+void MultichannelBiquadCascade<SampleType>::processStateVariableBands(Vec* samples, size_t numSamples,
+                                                                      const StateVariableBandCoefficients& c,
+                                                                      BandStates& bandState, const int* bandIndices) noexcept
+{
+    Vec g1[NumBands], g2[NumBands], g3[NumBands], m0[NumBands], m1[NumBands], m2[NumBands], s1[NumBands], s2[NumBands];
+
+    for (int k = 0; k < NumBands; ++k)
+    {
+        const auto band = static_cast<size_t>(bandIndices[k]);
+        g1[k] = c.g1[band];
+        g2[k] = c.g2[band];
+        g3[k] = c.g3[band];
+        m0[k] = c.m0[band];
+        m1[k] = c.m1[band];
+        m2[k] = c.m2[band];
+        s1[k] = bandState.s1[band];
+        s2[k] = bandState.s2[band];
+    }
+
+    const auto offset = Vec::expand(antiDenormal);
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        auto x = samples[i] + offset;
+
+        // The same state variable tick as the cuts.
+        for (int k = 0; k < NumBands; ++k)
+        {
+            const auto v3 = x - s2[k];
+            const auto v1 = g1[k] * s1[k] + g2[k] * v3;
+            const auto v2 = s2[k] + g2[k] * s1[k] + g3[k] * v3;
+            s1[k] = v1 + v1 - s1[k];
+            s2[k] = v2 + v2 - s2[k];
+            x = m0[k] * x + m1[k] * v1 + m2[k] * v2;
+        }
+
+        samples[i] = x;
+    }
+
+    for (int k = 0; k < NumBands; ++k)
+    {
+        const auto band = static_cast<size_t>(bandIndices[k]);
+        bandState.s1[band] = s1[k];
+        bandState.s2[band] = s2[k];
+    }
+}
+
+template <typename SampleType>
+const std::array<typename MultichannelBiquadCascade<SampleType>::StateVariableBandKernel,
+                 MultichannelBiquadCascade<SampleType>::maxBandsPerPass> MultichannelBiquadCascade<SampleType>::stateVariableBandKernels
+{{
+    &processStateVariableBands<1>, &processStateVariableBands<2>, &processStateVariableBands<3>, &processStateVariableBands<4>
+}};
+
+template <typename SampleType>
+typename MultichannelBiquadCascade<SampleType>::StateVariableStage
+    MultichannelBiquadCascade<SampleType>::makeStateVariable(const BiquadCoefficients& coefficients) noexcept
+{
+    /* The trapezoidal SVF with cutoff gain g = tan(w / 2) and damping k has the denominator
+     *     D(z) = d + 2 (g^2 - 1) z^-1 + (1 - g k + g^2) z^-2,  where d = 1 + g k + g^2,
+     * so comparing it with 1 + a1 z^-1 + a2 z^-2 at z = 1 and z = -1 gives 4 g^2 / d and 4 / d, and g and d follow.
+     * A stable section always has both positive. The band pass and low pass outputs have numerators g (1 - z^-2) and
+     * g^2 (1 + z^-1)^2, and the input D(z) itself, so matching b0 to b2 term by term gives the three mix gains.
+     */
+    const auto& source = coefficients;
+    const auto atDC = 1.0 + source.a1 + source.a2;
+    const auto atNyquist = 1.0 - source.a1 + source.a2;
+
+    if (atDC <= 0.0 || atNyquist <= 0.0)
+    {
+        jassertfalse;
+        return makeStateVariable(BiquadCoefficients {});
+    }
+
+    const auto gSquared = atDC / atNyquist;
+    const auto g = std::sqrt(gSquared);
+    const auto d = 4.0 / atNyquist;
+
+    // (1 - a2) d is 2 g k, the damping term.
+    const auto m0 = d * (source.b0 - source.b1 + source.b2) / 4.0;
+    const auto m1 = d * (source.b0 - source.b2 - (1.0 - source.a2) * m0) / (2.0 * g);
+    const auto m2 = (d * source.b1 - 2.0 * m0 * (gSquared - 1.0)) / (2.0 * gSquared);
+
+    auto expand = [](double value) { return Vec::expand(static_cast<SampleType>(value)); };
+
+    return { expand(1.0 / d), expand(g / d), expand(gSquared / d), expand(m0), expand(m1), expand(m2) };
+}
+
+template <typename SampleType>
+int MultichannelBiquadCascade<SampleType>::getKernelVariant(int numSections) noexcept
+{
+    jassert(numSections == 8 || (numSections >= 1 && numSections <= 4));
+    return numSections <= 4 ? juce::jmax(1, numSections) - 1 : 4;
+}
+
+// Rows are low cut variants and columns are high cut variants, in the order 1, 2, 3, 4 and 8 sections.
+template <typename SampleType>
+const std::array<std::array<typename MultichannelBiquadCascade<SampleType>::Kernel,
+                            MultichannelBiquadCascade<SampleType>::numKernelVariants>,
+                 MultichannelBiquadCascade<SampleType>::numKernelVariants> MultichannelBiquadCascade<SampleType>::kernels
+{{
+    {{ &processCascade<1, 1, Stage>, &processCascade<1, 2, Stage>, &processCascade<1, 3, Stage>, &processCascade<1, 4, Stage>, &processCascade<1, 8, Stage> }},
+    {{ &processCascade<2, 1, Stage>, &processCascade<2, 2, Stage>, &processCascade<2, 3, Stage>, &processCascade<2, 4, Stage>, &processCascade<2, 8, Stage> }},
+    {{ &processCascade<3, 1, Stage>, &processCascade<3, 2, Stage>, &processCascade<3, 3, Stage>, &processCascade<3, 4, Stage>, &processCascade<3, 8, Stage> }},
+    {{ &processCascade<4, 1, Stage>, &processCascade<4, 2, Stage>, &processCascade<4, 3, Stage>, &processCascade<4, 4, Stage>, &processCascade<4, 8, Stage> }},
+    {{ &processCascade<8, 1, Stage>, &processCascade<8, 2, Stage>, &processCascade<8, 3, Stage>, &processCascade<8, 4, Stage>, &processCascade<8, 8, Stage> }}
+}};
+
+// The same table, for the state variable form.
+template <typename SampleType>
+const std::array<std::array<typename MultichannelBiquadCascade<SampleType>::StateVariableKernel,
+                            MultichannelBiquadCascade<SampleType>::numKernelVariants>,
+                 MultichannelBiquadCascade<SampleType>::numKernelVariants> MultichannelBiquadCascade<SampleType>::stateVariableKernels
+{{
+    {{ &processCascade<1, 1, StateVariableStage>, &processCascade<1, 2, StateVariableStage>, &processCascade<1, 3, StateVariableStage>, &processCascade<1, 4, StateVariableStage>, &processCascade<1, 8, StateVariableStage> }},
+    {{ &processCascade<2, 1, StateVariableStage>, &processCascade<2, 2, StateVariableStage>, &processCascade<2, 3, StateVariableStage>, &processCascade<2, 4, StateVariableStage>, &processCascade<2, 8, StateVariableStage> }},
+    {{ &processCascade<3, 1, StateVariableStage>, &processCascade<3, 2, StateVariableStage>, &processCascade<3, 3, StateVariableStage>, &processCascade<3, 4, StateVariableStage>, &processCascade<3, 8, StateVariableStage> }},
+    {{ &processCascade<4, 1, StateVariableStage>, &processCascade<4, 2, StateVariableStage>, &processCascade<4, 3, StateVariableStage>, &processCascade<4, 4, StateVariableStage>, &processCascade<4, 8, StateVariableStage> }},
+    {{ &processCascade<8, 1, StateVariableStage>, &processCascade<8, 2, StateVariableStage>, &processCascade<8, 3, StateVariableStage>, &processCascade<8, 4, StateVariableStage>, &processCascade<8, 8, StateVariableStage> }}
+}};
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::prepare(int newNumChannels, int maximumBlockSize)
+{
+    jassert(newNumChannels > 0 && newNumChannels <= maxChannels);
+
+    numChannels = newNumChannels;
+    numGroups = (numChannels + static_cast<int>(Vec::size()) - 1) / static_cast<int>(Vec::size());
+
+    states.assign(static_cast<size_t>(numGroups * numStagePositions), State {});
+    bandStates.assign(static_cast<size_t>(numGroups), BandStates {});
+    groupCoefficients.assign(static_cast<size_t>(numGroups), GroupCoefficients {});
+    scratch.assign(static_cast<size_t>(juce::jmax(1, maximumBlockSize)), Vec::expand(0));
+
+    // Start out as a pass-through until the first real coefficients arrive.
+    clearCoefficients();
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::reset() noexcept
+{
+    std::fill(states.begin(), states.end(), State { Vec::expand(0), Vec::expand(0) });
+    std::fill(bandStates.begin(), bandStates.end(), BandStates {});
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::setTopology(Topology newTopology) noexcept
+{
+    if (newTopology == topology)
+        return;
+
+    topology = newTopology;
+    reset();
+
+    // The pass-throughs have to be there in the new form too, for any channel the next set doesn't reach.
+    clearCoefficients();
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::setMidSide(bool shouldUseMidSide) noexcept
+{
+    if (shouldUseMidSide == midSide)
+        return;
+
+    midSide = shouldUseMidSide;
+    reset();
+}
+
+template <typename SampleType>
+typename MultichannelBiquadCascade<SampleType>::StateCheck MultichannelBiquadCascade<SampleType>::checkState() noexcept
+{
+    // Comfortably below antiDenormal's effect on the state, so a settled filter isn't flushed over and over.
+    constexpr auto threshold = static_cast<SampleType>(1.0e-30);
+
+    StateCheck result;
+
+    auto check = [&result, threshold](SampleType* values, size_t numValues)
+    {
+        for (size_t i = 0; i < numValues; ++i)
+        {
+            if (! std::isfinite(values[i]))
+            {
+                result.wasReset = true;
+            }
+            else if (values[i] != 0 && std::abs(values[i]) < threshold)
+            {
+                values[i] = 0;
+                ++result.numFlushed;
+            }
+        }
+    };
+
+    check(reinterpret_cast<SampleType*>(states.data()), states.size() * sizeof(State) / sizeof(SampleType));
+    check(reinterpret_cast<SampleType*>(bandStates.data()), bandStates.size() * sizeof(BandStates) / sizeof(SampleType));
+
+    if (result.wasReset)
+        reset();
+
+    return result;
+}
+
+template <typename SampleType>
+juce::uint32 MultichannelBiquadCascade<SampleType>::getLanes(int group, juce::uint32 channels) const noexcept
+{
+    const auto firstChannel = group * static_cast<int>(Vec::size());
+    const auto numLanesUsed = juce::jmin(static_cast<int>(Vec::size()), numChannels - firstChannel);
+    const auto usedLanes = (1u << numLanesUsed) - 1;
+    const auto lanes = (channels >> firstChannel) & usedLanes;
+
+    return lanes == usedLanes ? allLanes : lanes;
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::assign(Vec& target, Vec value, juce::uint32 lanes) noexcept
+{
+    if (lanes == allLanes)
+    {
+        target = value;
+        return;
+    }
+
+    for (size_t lane = 0; lane < Vec::size(); ++lane)
+        if ((lanes >> lane) & 1)
+            target.set(lane, value.get(lane));
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::loadStage(GroupCoefficients& group, int position,
+                                                      const BiquadCoefficients& source, juce::uint32 lanes) noexcept
+{
+    const auto index = static_cast<size_t>(position);
+
+    if (topology == Topology::stateVariable)
+    {
+        const auto stage = makeStateVariable(source);
+        auto& target = group.stateVariableStages[index];
+        assign(target.g1, stage.g1, lanes);
+        assign(target.g2, stage.g2, lanes);
+        assign(target.g3, stage.g3, lanes);
+        assign(target.m0, stage.m0, lanes);
+        assign(target.m1, stage.m1, lanes);
+        assign(target.m2, stage.m2, lanes);
+        return;
+    }
+
+    auto& stage = group.stages[index];
+    assign(stage.b0, Vec::expand(static_cast<SampleType>(source.b0)), lanes);
+    assign(stage.b1, Vec::expand(static_cast<SampleType>(source.b1)), lanes);
+    assign(stage.b2, Vec::expand(static_cast<SampleType>(source.b2)), lanes);
+    assign(stage.a1, Vec::expand(static_cast<SampleType>(source.a1)), lanes);
+    assign(stage.a2, Vec::expand(static_cast<SampleType>(source.a2)), lanes);
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::loadBand(GroupCoefficients& group, size_t band,
+                                                     const BiquadCoefficients& source, juce::uint32 lanes) noexcept
+{
+    if (topology == Topology::stateVariable)
+    {
+        const auto stage = makeStateVariable(source);
+        auto& c = group.stateVariableBands;
+        assign(c.g1[band], stage.g1, lanes);
+        assign(c.g2[band], stage.g2, lanes);
+        assign(c.g3[band], stage.g3, lanes);
+        assign(c.m0[band], stage.m0, lanes);
+        assign(c.m1[band], stage.m1, lanes);
+        assign(c.m2[band], stage.m2, lanes);
+        return;
+    }
+
+    auto& c = group.bands;
+    assign(c.b0[band], Vec::expand(static_cast<SampleType>(source.b0)), lanes);
+    assign(c.b1[band], Vec::expand(static_cast<SampleType>(source.b1)), lanes);
+    assign(c.b2[band], Vec::expand(static_cast<SampleType>(source.b2)), lanes);
+    assign(c.a1[band], Vec::expand(static_cast<SampleType>(source.a1)), lanes);
+    assign(c.a2[band], Vec::expand(static_cast<SampleType>(source.a2)), lanes);
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::clearCoefficients() noexcept
+{
+    for (auto& group : groupCoefficients)
+    {
+        for (int position = 0; position < numStagePositions; ++position)
+            loadStage(group, position, {}, allLanes);
+
+        for (size_t band = 0; band < static_cast<size_t>(maxBands); ++band)
+            loadBand(group, band, {}, allLanes);
+    }
+
+    for (auto& active : bandActiveOnChannel)
+        active.fill(false);
+
+    lowCutSectionsOnChannel.fill(0);
+    highCutSectionsOnChannel.fill(0);
+
+    for (int group = 0; group < numGroups; ++group)
+        updateGroup(group);
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::updateGroup(int group) noexcept
+{
+    auto& target = groupCoefficients[static_cast<size_t>(group)];
+    const auto firstChannel = static_cast<size_t>(group) * Vec::size();
+    const auto lastChannel = juce::jmin(firstChannel + Vec::size(), static_cast<size_t>(numChannels));
+
+    auto numLowCutSections = 1, numHighCutSections = 1;
+    target.numActiveBands = 0;
+
+    for (auto channel = firstChannel; channel < lastChannel; ++channel)
+    {
+        numLowCutSections = juce::jmax(numLowCutSections, lowCutSectionsOnChannel[channel]);
+        numHighCutSections = juce::jmax(numHighCutSections, highCutSectionsOnChannel[channel]);
+    }
+
+    for (size_t band = 0; band < static_cast<size_t>(maxBands); ++band)
+    {
+        for (auto channel = firstChannel; channel < lastChannel; ++channel)
+        {
+            if (bandActiveOnChannel[channel][band])
+            {
+                target.activeBands[static_cast<size_t>(target.numActiveBands++)] = static_cast<int>(band);
+                break;
+            }
+        }
+    }
+
+    const auto lowCutVariant = static_cast<size_t>(getKernelVariant(numLowCutSections));
+    const auto highCutVariant = static_cast<size_t>(getKernelVariant(numHighCutSections));
+    target.kernel = kernels[lowCutVariant][highCutVariant];
+    target.stateVariableKernel = stateVariableKernels[lowCutVariant][highCutVariant];
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::setCoefficients(const ChainCoefficients& coefficients, Stages stagesToRun,
+                                                            const ChannelSelection& selection) noexcept
+{
+    // The low cut is the stage most likely to sit near DC, so when the chain is split it always runs in double.
+    const auto runLowCut  = selection.lowCut  && stagesToRun != Stages::notNeedingDoublePrecision;
+    const auto runHighCut = selection.highCut && stagesToRun != Stages::needingDoublePrecision;
+    const auto numLowCutSections  = runLowCut  ? coefficients.numLowCutSections  : 0;
+    const auto numHighCutSections = runHighCut ? coefficients.numHighCutSections : 0;
+
+    // The bands that actually do something on these channels. The rest are skipped, or passed through where they run.
+    std::array<bool, maxBands> isActive {};
+
+    for (size_t band = 0; band < static_cast<size_t>(maxBands); ++band)
+    {
+        const auto& source = coefficients.bands[band];
+        isActive[band] = ((selection.bands >> band) & 1) != 0
+                      && ! CoefficientDesign::isPassThrough(source)
+                      && (stagesToRun == Stages::all
+                          || CoefficientDesign::needsDoublePrecision(source) == (stagesToRun == Stages::needingDoublePrecision));
+    }
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        const auto lanes = getLanes(group, selection.channels);
+
+        if (lanes == 0)
+            continue;
+
+        auto& target = groupCoefficients[static_cast<size_t>(group)];
+        auto* groupStates = states.data() + group * numStagePositions;
+        auto& groupBandStates = bandStates[static_cast<size_t>(group)];
+        const auto firstChannel = static_cast<size_t>(group) * Vec::size();
+        const auto numLanesUsed = juce::jmin(Vec::size(), static_cast<size_t>(numChannels) - firstChannel);
+
+        auto clearLane = [](Vec& s1, Vec& s2, size_t lane)
+        {
+            s1.set(lane, 0);
+            s2.set(lane, 0);
+        };
+
+        /* A cut's sections run from its first position, and past its end every lane has pass-throughs, so lanes with
+         * shorter cuts can share a longer cut's kernel. A section that starts or stops being used on a channel starts
+         * again from silence.
+         */
+        auto loadCut = [&](int firstStage, const std::array<BiquadCoefficients, maxCutSections>& sections, bool run,
+                           int numSections, std::array<int, maxChannels>& sectionsOnChannel)
+        {
+            auto numToLoad = numSections;
+
+            for (size_t lane = 0; lane < numLanesUsed; ++lane)
+                if ((lanes >> lane) & 1)
+                    numToLoad = juce::jmax(numToLoad, sectionsOnChannel[firstChannel + lane]);
+
+            for (int i = 0; i < numToLoad; ++i)
+                loadStage(target, firstStage + i, run && i < numSections ? sections[static_cast<size_t>(i)] : BiquadCoefficients {}, lanes);
+
+            for (size_t lane = 0; lane < numLanesUsed; ++lane)
+            {
+                auto& previous = sectionsOnChannel[firstChannel + lane];
+
+                if (((lanes >> lane) & 1) == 0 || previous == numSections)
+                    continue;
+
+                for (auto i = juce::jmin(previous, numSections); i < juce::jmax(previous, numSections); ++i)
+                    clearLane(groupStates[firstStage + i].s1, groupStates[firstStage + i].s2, lane);
+
+                previous = numSections;
+            }
+        };
+
+        loadCut(firstLowCutStage, coefficients.lowCut, runLowCut, numLowCutSections, lowCutSectionsOnChannel);
+        loadCut(firstHighCutStage, coefficients.highCut, runHighCut, numHighCutSections, highCutSectionsOnChannel);
+
+        for (size_t band = 0; band < static_cast<size_t>(maxBands); ++band)
+        {
+            auto wasActive = false;
+
+            for (size_t lane = 0; lane < numLanesUsed; ++lane)
+                if ((lanes >> lane) & 1)
+                    wasActive = wasActive || bandActiveOnChannel[firstChannel + lane][band];
+
+            // A band that's off here is a pass-through on these lanes, in case it's still running on the others.
+            if (isActive[band] || wasActive)
+                loadBand(target, band, isActive[band] ? coefficients.bands[band] : BiquadCoefficients {}, lanes);
+
+            for (size_t lane = 0; lane < numLanesUsed; ++lane)
+            {
+                if (((lanes >> lane) & 1) == 0)
+                    continue;
+
+                auto& active = bandActiveOnChannel[firstChannel + lane][band];
+
+                // A band that's just come back on starts from silence, not from whatever it was holding when it went off.
+                if (isActive[band] && ! active)
+                    clearLane(groupBandStates.s1[band], groupBandStates.s2[band], lane);
+
+                active = isActive[band];
+            }
+        }
+
+        updateGroup(group);
+    }
+}
+
+template <typename SampleType>
+std::pair<double, double> MultichannelBiquadCascade<SampleType>::getBandState(int band, int channel) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(band, maxBands) && juce::isPositiveAndBelow(channel, numChannels));
+
+    const auto& groupState = bandStates[static_cast<size_t>(channel) / Vec::size()];
+    const auto lane = static_cast<size_t>(channel) % Vec::size();
+
+    return { static_cast<double>(groupState.s1[static_cast<size_t>(band)].get(lane)),
+             static_cast<double>(groupState.s2[static_cast<size_t>(band)].get(lane)) };
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::setBandState(int band, int channel, std::pair<double, double> state) noexcept
+{
+    jassert(juce::isPositiveAndBelow(band, maxBands) && juce::isPositiveAndBelow(channel, numChannels));
+
+    auto& groupState = bandStates[static_cast<size_t>(channel) / Vec::size()];
+    const auto lane = static_cast<size_t>(channel) % Vec::size();
+
+    groupState.s1[static_cast<size_t>(band)].set(lane, static_cast<SampleType>(state.first));
+    groupState.s2[static_cast<size_t>(band)].set(lane, static_cast<SampleType>(state.second));
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::setBandCoefficients(int band, const BiquadCoefficients& source) noexcept
+{
+    if (! juce::isPositiveAndBelow(band, maxBands))
+        return;
+
+    const auto index = static_cast<size_t>(band);
+
+    // Only the channels already running the band take the new coefficients.
+    for (int group = 0; group < numGroups; ++group)
+    {
+        juce::uint32 channels = 0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (bandActiveOnChannel[static_cast<size_t>(channel)][index])
+                channels |= 1u << channel;
+
+        if (const auto lanes = getLanes(group, channels); lanes != 0)
+            loadBand(groupCoefficients[static_cast<size_t>(group)], index, source, lanes);
+    }
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::setCutCoefficients(const ChainCoefficients& coefficients, bool lowCut, bool highCut) noexcept
+{
+    auto loadCut = [this](int firstStage, const std::array<BiquadCoefficients, maxCutSections>& sections,
+                          int numSections, const std::array<int, maxChannels>& sectionsOnChannel)
+    {
+        juce::uint32 channels = 0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto numOnChannel = sectionsOnChannel[static_cast<size_t>(channel)];
+
+            // A cut that changes length moves the kernel and the state, which only setCoefficients() takes care of.
+            jassert(numOnChannel == 0 || numOnChannel == numSections);
+
+            if (numOnChannel > 0)
+                channels |= 1u << channel;
+        }
+
+        for (int group = 0; group < numGroups; ++group)
+            if (const auto lanes = getLanes(group, channels); lanes != 0)
+                for (int i = 0; i < numSections; ++i)
+                    loadStage(groupCoefficients[static_cast<size_t>(group)], firstStage + i, sections[static_cast<size_t>(i)], lanes);
+    };
+
+    if (lowCut)
+        loadCut(firstLowCutStage, coefficients.lowCut, coefficients.numLowCutSections, lowCutSectionsOnChannel);
+
+    if (highCut)
+        loadCut(firstHighCutStage, coefficients.highCut, coefficients.numHighCutSections, highCutSectionsOnChannel);
+}
+
+template <typename SampleType>
+bool MultichannelBiquadCascade<SampleType>::isBandActive(int band) const noexcept
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+        if (bandActiveOnChannel[static_cast<size_t>(channel)][static_cast<size_t>(band)])
+            return true;
+
+    return false;
+}
+
+template <typename SampleType>
+int MultichannelBiquadCascade<SampleType>::getNumActiveBands() const noexcept
+{
+    auto numActive = 0;
+
+    for (int band = 0; band < maxBands; ++band)
+        if (isBandActive(band))
+            ++numActive;
+
+    return numActive;
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    jassert(static_cast<int>(block.getNumChannels()) <= numChannels);
+
+    const auto numSamples = block.getNumSamples();
+    const auto chunkSize = scratch.size();
+
+    // Hosts occasionally send more samples than they promised in prepareToPlay(), so work through the block in chunks.
+    for (size_t start = 0; start < numSamples; start += chunkSize)
+    {
+        const auto numThisTime = juce::jmin(chunkSize, numSamples - start);
+
+        for (int group = 0; group < numGroups; ++group)
+            processGroup(group, block, start, numThisTime);
+    }
+}
+
+template <typename SampleType>
+void MultichannelBiquadCascade<SampleType>::processGroup(int group,
+                                                         const juce::dsp::AudioBlock<SampleType>& block,
+                                                         size_t startSample,
+                                                         size_t numSamples) noexcept
+{
+    constexpr auto lanes = Vec::size();
+
+    const auto firstChannel = static_cast<size_t>(group) * lanes;
+    const auto numLanesUsed = juce::jmin(lanes, block.getNumChannels() - juce::jmin(firstChannel, block.getNumChannels()));
+
+    if (numLanesUsed == 0)
+        return;
+
+    // Interleave the group's channels into the scratch registers. Lanes with no channel behind them are fed silence.
+    auto* interleaved = reinterpret_cast<SampleType*>(scratch.data());
+
+    /* Mid/side is worked out on the way in and undone on the way out, so the mid and side sit in the first two lanes
+     * of the same registers as left and right would have, and run side by side with their own coefficients.
+     */
+    const auto encodeMidSide = midSide && group == 0 && numLanesUsed >= 2;
+    const auto half = static_cast<SampleType>(0.5);
+
+    if (encodeMidSide)
+    {
+        const auto* left = block.getChannelPointer(0) + startSample;
+        const auto* right = block.getChannelPointer(1) + startSample;
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            interleaved[i * lanes]     = (left[i] + right[i]) * half;
+            interleaved[i * lanes + 1] = (left[i] - right[i]) * half;
+        }
+    }
+
+    for (size_t lane = encodeMidSide ? 2 : 0; lane < lanes; ++lane)
+    {
+        if (lane < numLanesUsed)
+        {
+            const auto* channel = block.getChannelPointer(firstChannel + lane) + startSample;
+
+            for (size_t i = 0; i < numSamples; ++i)
+                interleaved[i * lanes + lane] = channel[i];
+        }
+        else
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+                interleaved[i * lanes + lane] = 0;
+        }
+    }
+
+    // Run both cut filters over every sample in one pass, then the active bands, a few at a time.
+    auto* groupStates = states.data() + group * numStagePositions;
+    auto& groupBandStates = bandStates[static_cast<size_t>(group)];
+    const auto& c = groupCoefficients[static_cast<size_t>(group)];
+
+    if (topology == Topology::stateVariable)
+    {
+        c.stateVariableKernel(scratch.data(), numSamples, c.stateVariableStages.data(), groupStates);
+
+        for (int first = 0; first < c.numActiveBands; first += maxBandsPerPass)
+        {
+            const auto numThisPass = juce::jmin(maxBandsPerPass, c.numActiveBands - first);
+            stateVariableBandKernels[static_cast<size_t>(numThisPass - 1)](scratch.data(), numSamples, c.stateVariableBands,
+                                                                           groupBandStates, c.activeBands.data() + first);
+        }
+    }
+    else
+    {
+        c.kernel(scratch.data(), numSamples, c.stages.data(), groupStates);
+
+        for (int first = 0; first < c.numActiveBands; first += maxBandsPerPass)
+        {
+            const auto numThisPass = juce::jmin(maxBandsPerPass, c.numActiveBands - first);
+            bandKernels[static_cast<size_t>(numThisPass - 1)](scratch.data(), numSamples, c.bands,
+                                                              groupBandStates, c.activeBands.data() + first);
+        }
+    }
+
+    // And write the result back out to the channels.
+    if (encodeMidSide)
+    {
+        auto* left = block.getChannelPointer(0) + startSample;
+        auto* right = block.getChannelPointer(1) + startSample;
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto mid = interleaved[i * lanes];
+            const auto side = interleaved[i * lanes + 1];
+            left[i] = mid + side;
+            right[i] = mid - side;
+        }
+    }
+
+    for (size_t lane = encodeMidSide ? 2 : 0; lane < numLanesUsed; ++lane)
+    {
+        auto* channel = block.getChannelPointer(firstChannel + lane) + startSample;
+
+        for (size_t i = 0; i < numSamples; ++i)
+            channel[i] = interleaved[i * lanes + lane];
+    }
+}
+
+template class MultichannelBiquadCascade<float>;
+template class MultichannelBiquadCascade<double>;
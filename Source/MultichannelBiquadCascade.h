@@ -0,0 +1,336 @@
+/*
+  ==============================================================================
+
+    MultichannelBiquadCascade.h
+
+    Runs the whole EQ chain over every channel of a bus at once, with one
+    channel per SIMD lane.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterDesign.h"
+
+#if ! JUCE_USE_SIMD
+ #error "MultichannelBiquadCascade needs juce::dsp::SIMDRegister, which isn't available on this platform."
+#endif
+
+/* Which channels of a bus a call to MultichannelBiquadCascade::setCoefficients() loads, as a bit mask, and which
+ * parts of the coefficient set they run. The parts that are left out are pass-throughs on those channels, so loading
+ * the same set into different channels with different selections gives them different settings from a single design.
+ */
+struct ChannelSelection
+{
+    static constexpr juce::uint32 allChannels = 0xffffffff;
+    static constexpr juce::uint32 allBands = 0xffffffff;
+
+    juce::uint32 channels { allChannels };
+
+    // Bit n is band n.
+    juce::uint32 bands { allBands };
+
+    bool lowCut { true };
+    bool highCut { true };
+};
+
+static_assert(maxBands <= 32, "ChannelSelection keeps one bit per band");
+
+/* Each biquad's output depends on its previous output, so a single channel can't be vectorised across time.
+ * Different channels are completely independent though, so this engine puts one channel in each lane of a
+ * juce::dsp::SIMDRegister (4 floats with SSE or NEON, 8 with AVX) and runs the same cascade on all of them with
+ * the same instructions. A stereo bus costs the same as a mono one, and a 7.1.4 bus only needs 2 to 3 passes.
+ *
+ * Channels are handled in groups of Vec::size(). For each group, the block is interleaved into a scratch buffer
+ * of registers, every stage of the chain is run over it in a single pass, and the result is written back.
+ * The state of every stage of a group sits together in one contiguous run, so a pass only touches a few cache lines.
+ *
+ * The cut filters run in one pass, which is one of a table of kernels, one per combination of low cut and high cut
+ * section counts. The number of stages is a template argument, so the compiler fully unrolls each cascade and keeps
+ * its coefficients and state in registers, and sections that aren't in use simply don't exist in that kernel.
+ * The kernel is picked when the coefficients change, so the cuts cost a single indirect call per group.
+ *
+ * The parametric bands can't be handled the same way, since any of up to maxBands of them may be in use. Their
+ * coefficients and state are kept as flat structures of arrays, indexed by band, with room for every band allocated
+ * up front. Whenever the coefficients change, the bands that aren't pass-throughs are gathered into a short list, and
+ * only those are run, up to maxBandsPerPass at a time in a single pass over the scratch buffer. A pass is again an
+ * unrolled kernel picked from a small table, so each active band costs exactly one biquad per sample, with no
+ * virtual calls or per-band branches, and a band that's off or flat costs nothing at all.
+ *
+ * The engine comes in float and double. For mixed precision, a double engine and a float engine can split the chain
+ * between them: the double one takes the low cut and any band with poles close to DC, and the float one the rest.
+ *
+ * Every section can run as a transposed direct form II biquad or as a state variable filter (see Topology). Both take
+ * the same BiquadCoefficients, and every kernel comes in both forms, so the choice is one table lookup, not a branch.
+ *
+ * Coefficients are kept per lane, so the channels in a group don't have to share settings: each lane runs the longest
+ * cut and every band that any lane in its group needs, with pass-through sections wherever its own settings have
+ * nothing. Left and right, or mid and side, then cost no more than a linked pair, since they share a register anyway.
+ * For mid/side, the first two channels are encoded as they're interleaved into the scratch registers and decoded as
+ * they're written back, so it takes no extra pass over the block and no extra buffer.
+ */
+template <typename SampleType>
+class MultichannelBiquadCascade
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+
+    // A 7.1.4 layout is the largest bus we expect to see.
+    static constexpr int maxChannels = 12;
+
+    // Where each cut section lives. Stages are kept at fixed positions so a slope change doesn't move any state.
+    enum StagePositions
+    {
+        firstLowCutStage = 0,
+        firstHighCutStage = maxCutSections,
+        numStagePositions = 2 * maxCutSections
+    };
+
+    /* Which part of a coefficient set an engine runs. Splitting a chain between two engines runs the low cut and the
+     * bands that need double precision (see CoefficientDesign::needsDoublePrecision()) in one, and the rest in the
+     * other. A cut that's left out still costs one pass-through section.
+     */
+    enum class Stages
+    {
+        all,
+        needingDoublePrecision,
+        notNeedingDoublePrecision
+    };
+
+    /* How each section is run. Transposed direct form II is the cheapest, but its coefficients crowd towards 1 and -2
+     * as a pole nears DC, so a low cut or shelf far below the rate gets noisy and drifts off its frequency in float.
+     * The state variable form is Andrew Simper's trapezoidal SVF: its state is two integrators whose gains scale with
+     * the cutoff, so it stays accurate however low the pole sits, for about one more multiply per section. It also
+     * copes far better with coefficients being changed under it while a ramp is running.
+     */
+    enum class Topology
+    {
+        transposedDirectForm2,
+        stateVariable
+    };
+
+    // Allocates the state and scratch space. Not real-time safe; call it from prepareToPlay().
+    void prepare(int numChannels, int maximumBlockSize);
+
+    /* Switches every section to the given topology. The two keep different state, so this clears it, and coefficients
+     * are only kept in the current form, so load them again straight after. Real-time safe.
+     */
+    void setTopology(Topology newTopology) noexcept;
+    Topology getTopology() const noexcept { return topology; }
+
+    // Clears the filter state of every channel.
+    void reset() noexcept;
+
+    /* Loads a new coefficient set, or the given part of one, into the selected channels; the rest keep what they have.
+     * Real-time safe.
+     */
+    void setCoefficients(const ChainCoefficients& coefficients, Stages stagesToRun = Stages::all,
+                         const ChannelSelection& selection = {}) noexcept;
+
+    /* Runs the first two channels as mid, (L + R) / 2, and side, (L - R) / 2, instead of left and right, so they can
+     * be given different settings. The state means something different either way, so this clears it. Real-time safe.
+     */
+    void setMidSide(bool shouldUseMidSide) noexcept;
+    bool isMidSide() const noexcept { return midSide; }
+
+    /* Replaces the coefficients of a single band, leaving its state alone. This is how dynamic bands follow their
+     * detectors, so it only touches a band that's already active; which bands run is still up to setCoefficients().
+     * Real-time safe.
+     */
+    void setBandCoefficients(int band, const BiquadCoefficients& coefficients) noexcept;
+
+    /* Replaces the coefficients of the low cut, the high cut or both on the channels already running them, leaving
+     * their state alone. Their lengths must be what setCoefficients() last gave them; a new slope needs that instead.
+     * Real-time safe.
+     */
+    void setCutCoefficients(const ChainCoefficients& coefficients, bool lowCut, bool highCut) noexcept;
+
+    // Filters the block in place. It must not have more channels than were passed to prepare().
+    void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    // What checkState() found.
+    struct StateCheck
+    {
+        // How many values had decayed far enough to be snapped to zero.
+        int numFlushed { 0 };
+
+        // Whether any value was NaN or infinite, in which case all of the state has been cleared.
+        bool wasReset { false };
+    };
+
+    /* Looks over every filter's state once. Anything that has decayed below -600 dB is snapped to exactly zero, as a
+     * last line of defence against denormals; see antiDenormal for the first. And if a NaN or an infinity has got in,
+     * from the input or from a wild coefficient set, the whole state is cleared, since otherwise it would recirculate
+     * forever and silence the channel for good. Real-time safe; call once per block.
+     */
+    StateCheck checkState() noexcept;
+
+    int getNumChannels() const noexcept { return numChannels; }
+
+    // Whether a band is being run on any channel, by the coefficients this engine was last given.
+    bool isBandActive(int band) const noexcept;
+
+    /* Reads or writes one channel's state for a band. When a band moves from one engine to the other as its
+     * frequency changes, its state goes with it, so it carries on without a click. Real-time safe.
+     */
+    std::pair<double, double> getBandState(int band, int channel) const noexcept;
+    void setBandState(int band, int channel, std::pair<double, double> state) noexcept;
+
+    // How many bands aren't pass-throughs on at least one channel, and so are actually being run.
+    int getNumActiveBands() const noexcept;
+
+private:
+    // Coefficients are stored as whole registers, one value per lane, so the inner loop never has to splat them.
+    struct Stage
+    {
+        static constexpr bool isStateVariable = false;
+        Vec b0, b1, b2, a1, a2;
+    };
+
+    /* The same section as a state variable filter: g1 to g3 are the integrator gains, and m0 to m2 mix the input, band
+     * pass and low pass outputs into the response. See makeStateVariable() for how they're worked out.
+     */
+    struct StateVariableStage
+    {
+        static constexpr bool isStateVariable = true;
+        Vec g1, g2, g3, m0, m1, m2;
+    };
+
+    /* Either form keeps two values per channel: the transposed direct form II delays, or the state variable filter's
+     * two integrator states.
+     */
+    struct State
+    {
+        Vec s1, s2;
+    };
+
+    /* A constant offset, far below anything audible, added to the input of each pass. Without it, a section fed silence
+     * decays towards zero forever and ends up crawling through denormals, which are very slow on some processors.
+     * With it, the state settles on a tiny DC value instead. The low cut blocks DC, so it's added again after that.
+     */
+    static constexpr SampleType antiDenormal = static_cast<SampleType>(1.0e-18);
+
+    // Runs a whole cascade over numSamples interleaved registers, reading and updating the state in place.
+    using Kernel = void (*)(Vec* samples, size_t numSamples, const Stage* stages, State* states) noexcept;
+    using StateVariableKernel = void (*)(Vec* samples, size_t numSamples, const StateVariableStage* stages, State* states) noexcept;
+
+    // Band coefficients and state, as one array per value, indexed by band.
+    struct BandCoefficients
+    {
+        std::array<Vec, maxBands> b0, b1, b2, a1, a2;
+    };
+
+    struct StateVariableBandCoefficients
+    {
+        std::array<Vec, maxBands> g1, g2, g3, m0, m1, m2;
+    };
+
+    struct BandStates
+    {
+        std::array<Vec, maxBands> s1, s2;
+    };
+
+    // Runs a few of the active bands, given by index, over numSamples interleaved registers.
+    using BandKernel = void (*)(Vec* samples, size_t numSamples, const BandCoefficients& coefficients,
+                                BandStates& states, const int* bandIndices) noexcept;
+
+    // Bands are run this many at a time, which keeps each pass's coefficients and state comfortably in registers.
+    static constexpr int maxBandsPerPass = 4;
+
+    using StateVariableBandKernel = void (*)(Vec* samples, size_t numSamples, const StateVariableBandCoefficients& coefficients,
+                                             BandStates& states, const int* bandIndices) noexcept;
+
+    template <int NumBands>
+    static void processBands(Vec* samples, size_t numSamples, const BandCoefficients& coefficients,
+                             BandStates& states, const int* bandIndices) noexcept;
+
+    template <int NumBands>
+    static void processStateVariableBands(Vec* samples, size_t numSamples, const StateVariableBandCoefficients& coefficients,
+                                          BandStates& states, const int* bandIndices) noexcept;
+
+    static const std::array<BandKernel, maxBandsPerPass> bandKernels;
+    static const std::array<StateVariableBandKernel, maxBandsPerPass> stateVariableBandKernels;
+
+    /* Converts a biquad into the state variable filter with the same response. Any stable section has one, since its
+     * denominator pins down the cutoff and damping, and the numerator is then matched by the three mix gains.
+     */
+    static StateVariableStage makeStateVariable(const BiquadCoefficients& coefficients) noexcept;
+
+    // The slope settings give 1, 2, 3, 4 or 8 sections, so there are five variants of each cut filter.
+    static constexpr int numKernelVariants = 5;
+
+    // Maps a number of cut sections onto its row or column in the kernel table.
+    static int getKernelVariant(int numSections) noexcept;
+
+    template <int NumLowCutSections, int NumHighCutSections, typename StageType>
+    static void processCascade(Vec* samples, size_t numSamples, const StageType* stages, State* states) noexcept;
+
+    static const std::array<std::array<Kernel, numKernelVariants>, numKernelVariants> kernels;
+    static const std::array<std::array<StateVariableKernel, numKernelVariants>, numKernelVariants> stateVariableKernels;
+
+    void processGroup(int group, const juce::dsp::AudioBlock<SampleType>& block, size_t startSample, size_t numSamples) noexcept;
+
+    // Everything one group of channels runs. Only the coefficients for the current topology are kept up to date.
+    struct GroupCoefficients
+    {
+        std::array<Stage, numStagePositions> stages;
+        std::array<StateVariableStage, numStagePositions> stateVariableStages;
+        BandCoefficients bands;
+        StateVariableBandCoefficients stateVariableBands;
+
+        // The bands that are active on at least one lane, in order.
+        std::array<int, maxBands> activeBands {};
+        int numActiveBands { 0 };
+
+        // The kernel for the longest cuts on any lane, in each form.
+        Kernel kernel { nullptr };
+        StateVariableKernel stateVariableKernel { nullptr };
+    };
+
+    // One bit per lane.
+    static constexpr juce::uint32 allLanes = (1u << Vec::SIMDNumElements) - 1;
+
+    /* The lanes of a group that a mask of channels covers. When it's every channel in the group, the lanes with no
+     * channel behind them are included too, so the coefficients can be broadcast rather than set lane by lane.
+     */
+    juce::uint32 getLanes(int group, juce::uint32 channels) const noexcept;
+
+    // Writes value into the given lanes of target.
+    static void assign(Vec& target, Vec value, juce::uint32 lanes) noexcept;
+
+    // Loads one section or band into some lanes of a group, in whichever form the current topology runs.
+    void loadStage(GroupCoefficients& group, int position, const BiquadCoefficients& coefficients, juce::uint32 lanes) noexcept;
+    void loadBand(GroupCoefficients& group, size_t band, const BiquadCoefficients& coefficients, juce::uint32 lanes) noexcept;
+
+    // Makes every section and band a pass-through on every channel.
+    void clearCoefficients() noexcept;
+
+    // Picks a group's kernel and gathers its active bands, after its lanes have changed.
+    void updateGroup(int group) noexcept;
+
+    Topology topology { Topology::transposedDirectForm2 };
+    bool midSide { false };
+
+    std::vector<GroupCoefficients> groupCoefficients;
+
+    /* What each channel was last given: whether it runs each band, and how many sections each cut has, with 0 for a
+     * cut the channel doesn't run. Past the end of a channel's cut, its sections are always pass-throughs.
+     */
+    std::array<std::array<bool, maxBands>, maxChannels> bandActiveOnChannel {};
+    std::array<int, maxChannels> lowCutSectionsOnChannel {};
+    std::array<int, maxChannels> highCutSectionsOnChannel {};
+
+    int numChannels { 0 };
+    int numGroups { 0 };
+
+    // numGroups runs of numStagePositions states, one run per group of channels.
+    std::vector<State> states;
+
+    // One set of band states per group of channels.
+    std::vector<BandStates> bandStates;
+
+    // One register per sample; each lane holds one channel of the group being processed.
+    std::vector<Vec> scratch;
+};
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    ParameterState.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterState.h"
+
+namespace
+{
+    /* Parameters that have been renamed, old ID first. States saved before a rename still carry the old ID's hash,
+     * so those records are read into the new parameter instead.
+     */
+    const std::pair<const char*, const char*> renamedParameters[]
+    {
+        // The single peak became the first of the parametric bands.
+        { "Peak Freq",    "Band 1 Freq" },
+        { "Peak Gain",    "Band 1 Gain" },
+        { "Peak Quality", "Band 1 Quality" }
+    };
+
+    float readFloat(const juce::uint8* source) noexcept
+    {
+        const auto bits = juce::ByteOrder::littleEndianInt(source);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+ParameterState::ParameterState(juce::AudioProcessorValueTreeState& apvts)
+{
+    for (auto* parameter : apvts.processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+        {
+            const auto hash = hashParameterID(ranged->paramID);
+
+            // Two IDs with the same hash would overwrite each other's values; rename one if this ever fires.
+            jassert(std::none_of(entries.begin(), entries.end(), [hash](const Entry& e) { return e.hash == hash; }));
+
+            entries.push_back({ hash, ranged, 0.f });
+        }
+    }
+
+    for (const auto& [oldID, newID] : renamedParameters)
+    {
+        const auto newHash = hashParameterID(newID);
+        auto entry = std::find_if(entries.begin(), entries.end(), [newHash](const Entry& e) { return e.hash == newHash; });
+
+        if (entry != entries.end())
+            renamedHashes.push_back({ hashParameterID(oldID), static_cast<size_t>(std::distance(entries.begin(), entry)) });
+    }
+
+    // The record count is stored in 16 bits.
+    jassert(entries.size() <= std::numeric_limits<juce::uint16>::max());
+}
+
+juce::uint32 ParameterState::hashParameterID(const juce::String& parameterID) noexcept
+{
+    juce::uint32 hash = 2166136261u;
+
+    for (auto* c = parameterID.toRawUTF8(); *c != 0; ++c)
+    {
+        hash ^= static_cast<juce::uint8>(*c);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+ParameterState::Entry* ParameterState::findEntry(juce::uint32 hash) noexcept
+{
+    for (auto& entry : entries)
+        if (entry.hash == hash)
+            return &entry;
+
+    for (const auto& [oldHash, index] : renamedHashes)
+        if (oldHash == hash)
+            return &entries[index];
+
+    return nullptr;
+}
+
+//==============================================================================
+void ParameterState::write(juce::MemoryBlock& destination) const
+{
+    // OutputStream writes numbers little-endian, whatever the platform.
+    juce::MemoryOutputStream stream(destination, false);
+
+    stream.writeInt(static_cast<int>(magic));
+    stream.writeShort(static_cast<short>(currentVersion));
+    stream.writeShort(static_cast<short>(headerSize));
+    stream.writeShort(static_cast<short>(recordSize));
+    stream.writeShort(static_cast<short>(entries.size()));
+    stream.writeInt(0);
+
+    for (const auto& entry : entries)
+    {
+        stream.writeInt(static_cast<int>(entry.hash));
+        stream.writeFloat(entry.parameter->convertFrom0to1(entry.parameter->getValue()));
+    }
+}
+
+bool ParameterState::isValid(const void* data, size_t sizeInBytes) noexcept
+{
+    if (data == nullptr || sizeInBytes < headerSize)
+        return false;
+
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+
+    const auto storedHeaderSize = juce::ByteOrder::littleEndianShort(bytes + 6);
+    const auto storedRecordSize = juce::ByteOrder::littleEndianShort(bytes + 8);
+    const auto numRecords = juce::ByteOrder::littleEndianShort(bytes + 10);
+
+    // A newer version may have made the header or the records bigger, but never smaller.
+    return juce::ByteOrder::littleEndianInt(bytes) == magic
+           && storedHeaderSize >= headerSize
+           && storedRecordSize >= recordSize
+           && sizeInBytes >= storedHeaderSize + static_cast<size_t>(numRecords) * storedRecordSize;
+}
+
+bool ParameterState::apply(const void* data, size_t sizeInBytes)
+{
+    if (! isValid(data, sizeInBytes))
+        return false;
+
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+
+    const auto storedHeaderSize = juce::ByteOrder::littleEndianShort(bytes + 6);
+    const auto storedRecordSize = juce::ByteOrder::littleEndianShort(bytes + 8);
+    const auto numRecords = juce::ByteOrder::littleEndianShort(bytes + 10);
+
+    /* Version 1 is the only format so far. If a later version changes what a stored value means, the header's
+     * version is where to tell the two apart, and older values get converted here before they're used.
+     */
+
+    // Anything the state doesn't mention goes back to its default, so a preset always sounds the same.
+    for (auto& entry : entries)
+        entry.pendingValue = entry.parameter->convertFrom0to1(entry.parameter->getDefaultValue());
+
+    const auto* record = bytes + storedHeaderSize;
+
+    for (int i = 0; i < numRecords; ++i, record += storedRecordSize)
+    {
+        const auto hash = juce::ByteOrder::littleEndianInt(record);
+        const auto value = readFloat(record + 4);
+
+        // Records written by a newer build for parameters we don't have are skipped, as are corrupt values.
+        if (auto* entry = findEntry(hash); entry != nullptr && std::isfinite(value))
+            entry->pendingValue = value;
+    }
+
+    for (const auto& entry : entries)
+    {
+        const auto normalised = entry.parameter->convertTo0to1(entry.pendingValue);
+
+        // Hosts treat every notification as an edit, so leave alone anything that isn't changing.
+        if (normalised != entry.parameter->getValue())
+            entry.parameter->setValueNotifyingHost(normalised);
+    }
+
+    return true;
+}
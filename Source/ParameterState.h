@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    ParameterState.h
+
+    A compact binary format for the plugin's parameter values.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/* Hosts ask for the state whenever they autosave or take an undo snapshot, often for hundreds of instances at once,
+ * so going through a ValueTree and XML every time would be slow. This format is a small fixed header followed by a
+ * fixed-size record per parameter, and can be read straight out of memory without any parsing:
+ *
+ *     header:  uint32 magic ('BEQS'), uint16 version, uint16 headerSize, uint16 recordSize, uint16 numRecords,
+ *              uint32 reserved
+ *     record:  uint32 hash of the parameter ID, float value
+ *
+ * Everything is little-endian. Values are stored in the parameter's own units (Hz, dB, a choice index) rather than
+ * normalised, so a preset still means the same thing if a parameter's range is widened later.
+ *
+ * The format is built to be read by both older and newer builds. Records are matched by ID hash rather than position,
+ * so records for parameters this build doesn't know about are skipped, and parameters the state doesn't mention go
+ * back to their defaults. Records for a parameter that has since been renamed are read into its new ID. headerSize
+ * and recordSize are stored rather than assumed, so a later version can add fields to either and still be read here.
+ */
+class ParameterState
+{
+public:
+    // Builds the ID hash table from every parameter the APVTS owns.
+    explicit ParameterState(juce::AudioProcessorValueTreeState& apvts);
+
+    // Replaces destination with the current value of every parameter.
+    void write(juce::MemoryBlock& destination) const;
+
+    /* Sets every parameter from a state written by write(), or returns false and leaves them alone if it isn't one.
+     * Call it on the message thread. Each parameter is set in turn, so the caller decides how to make the change
+     * look atomic to anything that's listening.
+     */
+    bool apply(const void* data, size_t sizeInBytes);
+
+    // Checks the header and the length, without touching any parameters.
+    static bool isValid(const void* data, size_t sizeInBytes) noexcept;
+
+    static constexpr juce::uint32 magic = 0x53514542; // "BEQS", read as a little-endian uint32
+    static constexpr juce::uint16 currentVersion = 1;
+
+private:
+    static constexpr size_t headerSize = 16;
+    static constexpr size_t recordSize = 8;
+
+    // 32-bit FNV-1a, which is plenty to tell a handful of parameter IDs apart.
+    static juce::uint32 hashParameterID(const juce::String& parameterID) noexcept;
+
+    struct Entry
+    {
+        juce::uint32 hash { 0 };
+        juce::RangedAudioParameter* parameter { nullptr };
+
+        // Scratch for apply(), so a state can be gathered in full before any parameter is touched.
+        float pendingValue { 0.f };
+    };
+
+    std::vector<Entry> entries;
+
+    // The hashes of renamed parameters' old IDs, and the entry each one now belongs to.
+    std::vector<std::pair<juce::uint32, size_t>> renamedHashes;
+
+    // Finds the entry for a record's hash, including old IDs; nullptr if there isn't one.
+    Entry* findEntry(juce::uint32 hash) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterState)
+};
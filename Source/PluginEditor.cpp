@@ -13,9 +13,24 @@
 BasicEQAudioProcessorEditor::BasicEQAudioProcessorEditor (BasicEQAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
+    addAndMakeVisible(analyzer);
+    addAndMakeVisible(responseCurve);
+    addAndMakeVisible(parameterEditor);
+    
+    if (CallbackTelemetry::isEnabled())
+    {
+        telemetryReadout.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+        telemetryReadout.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+        addAndMakeVisible(telemetryReadout);
+        
+        // The aggregator only updates a few times a second anyway, so there's no point polling any faster.
+        startTimerHz(4);
+    }
+    
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (juce::jmax(600, parameterEditor.getWidth()),
+             analyzerHeight + parameterEditor.getHeight() + (CallbackTelemetry::isEnabled() ? telemetryHeight : 0));
 }
 
 BasicEQAudioProcessorEditor::~BasicEQAudioProcessorEditor()
@@ -28,10 +43,6 @@ void BasicEQAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    g.setColour (juce::Colours::white);
-    g.setFont (15.0f);
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
 }
 
 // Examples of subcomponents include buttons, knobs, sliders, spectrum analyzers, etc.
@@ -39,4 +50,30 @@ void BasicEQAudioProcessorEditor::resized()
 {
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
+    auto bounds = getLocalBounds();
+    analyzer.setBounds(bounds.removeFromTop(analyzerHeight));
+    responseCurve.setBounds(analyzer.getBounds());
+    
+    if (CallbackTelemetry::isEnabled())
+        telemetryReadout.setBounds(bounds.removeFromBottom(telemetryHeight));
+    
+    parameterEditor.setBounds(bounds);
+}
+
+void BasicEQAudioProcessorEditor::timerCallback()
+{
+    const auto snapshot = audioProcessor.getTelemetry().getSnapshot();
+    const auto startup = audioProcessor.getStartupTiming();
+    
+    telemetryReadout.setText("CPU p50/p99/max " + juce::String(snapshot.cpuMicrosecondsP50, 1)
+                             + " / " + juce::String(snapshot.cpuMicrosecondsP99, 1)
+                             + " / " + juce::String(snapshot.cpuMicrosecondsMax, 1) + " us   "
+                             + "deadline p99 " + juce::String(snapshot.deadlineRatioP99 * 100.0, 1) + "%   "
+                             + "updates " + juce::String(snapshot.coefficientUpdates) + "   "
+                             + "denormal " + juce::String(snapshot.denormalGuardHits) + "   "
+                             + "resets " + juce::String(snapshot.stateResets) + "   "
+                             + "silent " + juce::String(snapshot.silentCallbacks) + "   "
+                             + "startup " + juce::String(startup.constructionMilliseconds, 1)
+                             + " + " + juce::String(startup.prepareMilliseconds, 1) + " ms",
+                             juce::dontSendNotification);
 }
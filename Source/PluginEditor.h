@@ -10,11 +10,14 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SpectrumAnalyzer.h"
+#include "ResponseCurveComponent.h"
 
 //==============================================================================
 /**
 */
-class BasicEQAudioProcessorEditor  : public juce::AudioProcessorEditor
+class BasicEQAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                     private juce::Timer
 {
 public:
     BasicEQAudioProcessorEditor (BasicEQAudioProcessor&);
@@ -28,6 +31,23 @@ private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     BasicEQAudioProcessor& audioProcessor;
+    
+    // The spectrum of the processed signal, along the top.
+    SpectrumAnalyzer analyzer {audioProcessor.getAnalyzerFifo()};
+    static constexpr int analyzerHeight = 240;
+    
+    // The EQ's frequency response, drawn over the analyzer.
+    ResponseCurveComponent responseCurve {audioProcessor};
+    
+    // Until we have our own controls, the generic editor gives us a slider or combo box for every parameter.
+    juce::GenericAudioProcessorEditor parameterEditor {audioProcessor};
+    
+    // A line of callback timing figures along the bottom; only shown when telemetry is compiled in.
+    juce::Label telemetryReadout;
+    static constexpr int telemetryHeight = 24;
+    
+    // Refreshes the telemetry readout a few times a second.
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BasicEQAudioProcessorEditor)
 };
@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "DesignTables.h"
 
 //==============================================================================
 BasicEQAudioProcessor::BasicEQAudioProcessor()
@@ -16,16 +17,46 @@ BasicEQAudioProcessor::BasicEQAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       // Optional; dynamic bands can listen to this instead of the input. Off until the host turns it on.
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    /* Every time the pipeline designs a new coefficient set, keep the tail length up to date and, in linear phase
+     * mode, ask for a matching kernel. Switching the phase mode also goes through here, since it's a parameter too,
+     * which makes this the place to notice that the latency has changed. The same goes for oversampling.
+     */
+    coefficientPipeline.onPublished = [this](const ChainCoefficients& coefficients)
+    {
+        filterTailSeconds = CoefficientDesign::getDecayTimeSeconds(coefficients);
+        
+        // Whatever this set needs is built here, on the worker, the first time it's needed.
+        prepareOversampler(coefficients);
+        
+        if (isLinearPhaseSelected())
+        {
+            if (linearPhaseConvolver.isReady())
+                linearPhaseConvolver.requestKernel(coefficients);
+            else
+                linearPhaseConvolver.allocate(coefficients);
+        }
+        
+        if (getLatencyForSelectedMode() != getLatencySamples())
+            triggerAsyncUpdate();
+    };
+    
+    addAutomationTargets();
+    
+    constructionMilliseconds = juce::Time::getMillisecondCounterHiRes() - constructionStartTime;
 }
 
 BasicEQAudioProcessor::~BasicEQAudioProcessor()
 {
+    // The pipeline's worker can build oversamplers, which are destroyed before the pipeline is; stop it first.
+    coefficientPipeline.release();
 }
 
 //==============================================================================
@@ -63,7 +94,11 @@ bool BasicEQAudioProcessor::isMidiEffect() const
 
 double BasicEQAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The FIR rings for half its length either side of the centre tap; the IIR chain until its slowest pole dies away.
+    if (isLinearPhaseSelected())
+        return linearPhaseConvolver.getTailLengthSeconds();
+    
+    return filterTailSeconds.load();
 }
 
 int BasicEQAudioProcessor::getNumPrograms()
@@ -95,55 +130,174 @@ void BasicEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBloc
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+    const auto prepareStartTime = juce::Time::getMillisecondCounterHiRes();
     
-    /* We must prepare any filters before we use them; this is done by using a process
-     * spec object for the chains.
+    /* We must prepare the filters before we use them. The engine handles every channel of the main bus in
+     * one go, so it needs to know how many there are and the most samples it'll process at once. With oversampling
+     * that's up to 8 times as many as the host sends. The pipeline's worker can reach the oversamplers, so it has
+     * to be stopped while they're cleared out.
      */
-    juce::dsp::ProcessSpec spec;
+    coefficientPipeline.release();
     
-    // The spec needs to know the maximum amount of samples it'll process at once.
-    spec.maximumBlockSize = samplesPerBlock;
+    const auto numChannels = juce::jmax(1, getMainBusNumOutputChannels());
+    maximumBlockSize = static_cast<size_t>(juce::jmax(1, samplesPerBlock));
+    const auto maximumEngineBlockSize = samplesPerBlock * CoefficientDesign::getOversamplingFactor(3);
+    filterEngine.prepare(numChannels, maximumEngineBlockSize);
     
-    // The spec needs to know the number of channels
-    spec.numChannels = 1;
+    // The double engine is small, and mixed precision can be switched on at any time, so it's always ready too.
+    doubleFilterEngine.prepare(numChannels, maximumEngineBlockSize);
+    mixedPrecisionBuffer.setSize(numChannels, juce::jmax(1, maximumEngineBlockSize));
+    mixedPrecisionActive = isMixedPrecisionSelected() && ! isUsingDoublePrecision();
+    applyFilterTopology();
     
-    // The spec needs to know the sample rate.
-    spec.sampleRate = sampleRate;
+    /* Front/Rear mode goes by the layout. With a layout that doesn't say where its channels are, they all count as
+     * being at the front.
+     */
+    const auto channelLayout = getChannelLayoutOfBus(false, 0);
+    frontChannels = 0;
     
-    // Now we can prepare the left & right mono chains using the spec.
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        switch (channelLayout.getTypeOfChannel(channel))
+        {
+            case juce::AudioChannelSet::left:
+            case juce::AudioChannelSet::right:
+            case juce::AudioChannelSet::centre:
+            case juce::AudioChannelSet::LFE:
+            case juce::AudioChannelSet::LFE2:
+            case juce::AudioChannelSet::leftCentre:
+            case juce::AudioChannelSet::rightCentre:
+            case juce::AudioChannelSet::wideLeft:
+            case juce::AudioChannelSet::wideRight:
+                frontChannels |= 1u << channel;
+                break;
+                
+            default:
+                break;
+        }
+    }
+    
+    if (frontChannels == 0)
+        frontChannels = ChannelSelection::allChannels;
+    
+    applyChannelMode();
+    
+    // Oversamplers are built for the new layout as they're needed; see prepareOversampler().
+    oversamplerNumChannels = numChannels;
+    
+    auto clearOversamplers = [](auto& slots)
+    {
+        for (size_t filterIndex = 0; filterIndex < 2; ++filterIndex)
+        {
+            for (size_t factorIndex = 0; factorIndex < 3; ++factorIndex)
+            {
+                slots.readyOversamplers[filterIndex][factorIndex] = nullptr;
+                slots.oversamplers[filterIndex][factorIndex].reset();
+            }
+        }
+        
+        slots.activeOversampler = nullptr;
+    };
+    
+    clearOversamplers(floatOversamplers);
+    clearOversamplers(doubleOversamplers);
+    
+    /* The linear phase convolver only works out its sizes here, which is enough to know its latency.
+     * Everything else waits until linear phase is actually selected.
+     */
+    linearPhaseConvolver.prepare(numChannels, sampleRate);
     
-    // Get our chain settings.
-    auto chainSettings = getChainSettings(apvts);
+    // The designers' lookup tables are built once per process, on first use; make sure that's here rather than later.
+    DesignTables::getInstance();
     
-    /* Create a coefficient set for our peak filter.
-     * The gain parameter expects gain in gain units, not dB, so we will have to convert.
+    /* Design the first coefficient set synchronously, since we're not on the audio thread yet.
+     * From here on, the coefficient pipeline's worker thread takes care of parameter changes and
+     * processBlock() just picks up whatever it publishes.
      */
-    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-                                                                                chainSettings.peakFrequency,
-                                                                                chainSettings.peakQuality,
-                                                                                juce::Decibels::decibelsToGain(chainSettings.peakGainDecibels));
-    
-    /* You can access links in the chain through the get() function, using an index.
-     * We will use an enum to make this easier to use.
-     *
-     * The coefficients objects are reference-counted objects that each own a juce::Array<float>.
-     * The helpfer functions return the instances on the heap, so they must be dereferenced to get
-     * the underlying coefficients.
-     * Allocating on the heap in an audio callback is generally not a good idea.
-     *
-     * This step is where audible changes begin to occur, but in order for the plugin to work when
-     * changing sliders, we have to have it update these coefficients when the sliders move.
+    chainCoefficients = coefficientPipeline.prepare(sampleRate);
+    coefficientRamp.reset(chainCoefficients);
+    samplesUntilRampStep = 0;
+    updateFilters(chainCoefficients);
+    filterTailSeconds = CoefficientDesign::getDecayTimeSeconds(chainCoefficients);
+    
+    dynamicBandDetector.reset();
+    prepareDynamicBands();
+    
+    // The first set came straight from the parameters, so the splitter's copy starts from them too.
+    automationSplitter.endBlock(automatedSettings);
+    automatedGeneration = coefficientPipeline.getGeneration();
+    
+    silentSamples = 0;
+    sleeping = false;
+    
+    /* Only what the current settings use is built now; the worker may already be building the same things, which is
+     * fine, since both paths check first. The latency depends on all of it, so the host is told from here as well.
+     */
+    prepareOversampler(chainCoefficients);
+    
+    if (isLinearPhaseSelected())
+        linearPhaseConvolver.allocate(chainCoefficients);
+    
+    linearPhaseActive = isLinearPhaseSelected() && linearPhaseConvolver.isReady();
+    setLatencySamples(getLatencyForSelectedMode());
+    
+    analyzerFifo.setSampleRate(sampleRate);
+    telemetry.prepare(sampleRate);
+    
+    prepareMilliseconds = juce::Time::getMillisecondCounterHiRes() - prepareStartTime;
+}
+
+void BasicEQAudioProcessor::prepareOversampler(const ChainCoefficients& coefficients)
+{
+    const auto oversamplingIndex = juce::roundToInt(std::log2(coefficients.sampleRate / getSampleRate()));
+    
+    if (oversamplingIndex <= 0)
+        return;
+    
+    const auto filterIndex = static_cast<size_t>(juce::jlimit(0, 1, coefficients.oversamplingFilter));
+    const auto factorIndex = static_cast<size_t>(juce::jmin(oversamplingIndex, 3) - 1);
+    
+    // The host picks the precision before prepareToPlay(), so only the oversamplers for that one are ever needed.
+    if (isUsingDoublePrecision())
+        prepareOversampler(doubleOversamplers, filterIndex, factorIndex);
+    else
+        prepareOversampler(floatOversamplers, filterIndex, factorIndex);
+}
+
+template <typename SampleType>
+void BasicEQAudioProcessor::prepareOversampler(OversamplerSlots<SampleType>& slots, size_t filterIndex, size_t factorIndex)
+{
+    using Oversampler = typename OversamplerSlots<SampleType>::Oversampler;
+    
+    const juce::ScopedLock sl(oversamplerLock);
+    auto& oversampler = slots.oversamplers[filterIndex][factorIndex];
+    
+    if (oversampler != nullptr)
+        return;
+    
+    /* The polyphase IIR half-band filters are the cheap, low latency choice that's meant to be left on.
+     * The equiripple FIR ones are linear phase, and worth the extra cost and latency when mastering.
      */
-    *leftChain.get<ChainPositions::Peak>().coefficients = *peakCoefficients;
-    *rightChain.get<ChainPositions::Peak>().coefficients = *peakCoefficients;
+    const auto isFIR = filterIndex == 1;
+    
+    oversampler = std::make_unique<Oversampler>(static_cast<size_t>(oversamplerNumChannels),
+                                                factorIndex + 1,
+                                                isFIR ? Oversampler::filterHalfBandFIREquiripple
+                                                      : Oversampler::filterHalfBandPolyphaseIIR,
+                                                isFIR,
+                                                true);
+    oversampler->initProcessing(maximumBlockSize);
+    
+    slots.readyOversamplers[filterIndex][factorIndex].store(oversampler.get(), std::memory_order_release);
 }
 
 void BasicEQAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    coefficientPipeline.release();
+    linearPhaseConvolver.release();
+    telemetry.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -154,17 +308,21 @@ bool BasicEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     return true;
   #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // The filter engine handles any layout from mono up to 7.1.4, since every
+    // channel just gets its own SIMD lane.
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+    
+    if (numChannels < 1 || numChannels > MultichannelBiquadCascade<float>::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+    
+    // The sidechain is only ever mixed down to mono, so anything up to stereo will do, or nothing at all.
+    if (layouts.inputBuses.size() > 1 && layouts.getNumChannels(true, 1) > 2)
+        return false;
    #endif
 
     return true;
@@ -173,10 +331,23 @@ bool BasicEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 #endif
 
 // This is where you get allocated audio data (buffer) and can work with midi messages.
-void BasicEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void BasicEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processBlockInternal(buffer);
+}
+
+void BasicEQAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processBlockInternal(buffer);
+}
+
+template <typename SampleType>
+void BasicEQAudioProcessor::processBlockInternal(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
+    const CallbackTelemetry::ScopedCallback telemetryScope(telemetry, buffer.getNumSamples());
+    // The sidechain counts as an input too, but it never reaches the outputs, so only the main bus counts here.
+    auto totalNumInputChannels  = getMainBusNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     // In case we have more outputs than inputs, this code clears any output
@@ -195,29 +366,710 @@ void BasicEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
     // Alternatively, you can process the samples with the channels
     // interleaved by keeping the same state.
     
-    /* The processor chain requires a processing context in order to properly
-     * run the audio through each link in the chain. To make the context,
-     * we need to provide an audio block instance.
-     * The processBlock function is called by the host and given a buffer
-     * which can have any number of channels; we need to find the left and right
-     * channel from this buffer. Left and Right are typically channels 0 and 1,
-     * respectively.
+    /* The filter engine works on an audio block instance wrapped around the buffer.
+     * The processBlock function is called by the host and given a buffer which can have
+     * any number of channels; the engine takes every channel of the main bus at once,
+     * so there's no need to pick out the left and right channels individually.
+     */
+    
+    // Pick up any coefficients the pipeline has designed since the last block. This never blocks.
+    const auto subBlockSize = getSmoothingSubBlockSize(static_cast<int>(smoothingParameter->load()));
+    
+    const auto generation = coefficientPipeline.getGeneration();
+    juce::uint32 pulledGeneration {0};
+    
+    /* After a split block, a set the pipeline designed from parameters read before that block started would take us
+     * back in time, so it's dropped. One designed since then is already on its way.
+     */
+    if (coefficientPipeline.pullLatest(pulledCoefficients, &pulledGeneration)
+        && static_cast<juce::int32>(pulledGeneration - automatedGeneration) >= 0)
+    {
+        chainCoefficients = pulledCoefficients;
+        telemetry.addCoefficientUpdate();
+        
+        if (subBlockSize > 0)
+        {
+            // Glide to the new coefficients over roughly smoothingTimeSeconds, one step per sub-block.
+            const auto numSteps = juce::roundToInt(smoothingTimeSeconds * chainCoefficients.sampleRate / subBlockSize);
+            coefficientRamp.setTarget(chainCoefficients, juce::jmax(1, numSteps));
+        }
+        else
+        {
+            coefficientRamp.reset(chainCoefficients);
+            updateFilters(chainCoefficients);
+        }
+        
+        prepareDynamicBands();
+    }
+    
+    // Mixed precision only applies to float buffers; switching it moves stages between engines, so both start afresh.
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        if (isMixedPrecisionSelected() != mixedPrecisionActive)
+        {
+            mixedPrecisionActive = ! mixedPrecisionActive;
+            updateFilters(coefficientRamp.getCurrent());
+            resetFilters();
+        }
+    }
+    
+    /* The state means something different in each topology, so a switch clears it and converts the coefficients.
+     * The same goes for the channel mode, which moves filters between channels and turns mid/side on or off.
+     */
+    const auto topologyChanged = applyFilterTopology();
+    
+    if (applyChannelMode() || topologyChanged)
+        updateFilters(coefficientRamp.getCurrent());
+    
+    // First the block, in whichever precision the host gave us. Only the main bus goes through the EQ.
+    juce::dsp::AudioBlock<SampleType> block(buffer);
+    auto mainBlock = block.getSubsetChannelBlock(0, static_cast<size_t>(filterEngine.getNumChannels()));
+    
+    // The sidechain bus, when the host has connected one; otherwise the dynamic bands listen to the main bus.
+    auto sidechainBuffer = getBusBuffer(buffer, true, 1);
+    const auto sidechainBlock = sidechainBuffer.getNumChannels() > 0 ? juce::dsp::AudioBlock<SampleType>(sidechainBuffer) : mainBlock;
+    
+    /* Whichever path we switch to starts from a clean slate, rather than carrying on from state that's gone stale.
+     * The host is told about the new latency separately, from the pipeline's worker, which is also what gets the
+     * convolver ready the first time linear phase is selected; until then we carry on as we are.
+     */
+    if ((isLinearPhaseSelected() && linearPhaseConvolver.isReady()) != linearPhaseActive)
+    {
+        linearPhaseActive = ! linearPhaseActive;
+        
+        if (linearPhaseActive)
+            linearPhaseConvolver.reset();
+        else
+            resetFilters();
+    }
+    
+    /* An instance on a silent track shouldn't cost anything. Once the input has been silent for longer than the
+     * current path's latency and tail, the output would be silence too, so the block is left as it is. Everything is
+     * cleared on the way in, so when sound arrives it starts from a clean slate, just as it would after prepareToPlay().
+     */
+    if (isSilent(mainBlock))
+        silentSamples += static_cast<juce::int64>(mainBlock.getNumSamples());
+    else
+        silentSamples = 0;
+    
+    if ((silentSamples > getSilenceHoldSamples()) != sleeping)
+    {
+        sleeping = ! sleeping;
+        
+        if (sleeping)
+            resetSignalPath();
+    }
+    
+    if (sleeping)
+    {
+        // Nobody can hear a glide while we're asleep, so any ramp jumps straight to where it's going.
+        if (coefficientRamp.isRamping())
+        {
+            coefficientRamp.reset(chainCoefficients);
+            updateFilters(chainCoefficients);
+        }
+        
+        telemetry.addSilentCallback();
+        analyzerFifo.push(mainBlock);
+        automationSplitter.endBlock(automatedSettings);
+        return;
+    }
+    
+    if (linearPhaseActive)
+    {
+        // The convolver crossfades kernels itself, so the IIR side just jumps ahead, ready for a switch back.
+        if (coefficientRamp.isRamping())
+        {
+            coefficientRamp.reset(chainCoefficients);
+            updateFilters(chainCoefficients);
+        }
+        
+        linearPhaseConvolver.process(mainBlock);
+    }
+    else
+    {
+        // Changes queued with addParameterChange() split the block; the linear phase path just takes the block's end values.
+        if (automationSplitter.hasChanges())
+            processAutomated(mainBlock, sidechainBlock, subBlockSize, generation);
+        else
+            processFilters(mainBlock, sidechainBlock, subBlockSize);
+        
+        /* Once per block is plenty to stop a decaying tail from wandering into denormals, and to catch a NaN or an
+         * infinity before it can recirculate. When one has got in, this block is garbage, so it goes out as silence
+         * and everything that might be holding on to it starts again. The convolver doesn't need this; it's an FIR,
+         * so anything that gets in has gone again after one kernel length.
+         */
+        auto numFlushed = 0;
+        auto wasReset = false;
+        
+        auto checkEngine = [&numFlushed, &wasReset](auto& engine)
+        {
+            const auto result = engine.checkState();
+            numFlushed += result.numFlushed;
+            wasReset = wasReset || result.wasReset;
+        };
+        
+        checkEngine(getFilterEngine<SampleType>());
+        
+        if (std::is_same_v<SampleType, float> && mixedPrecisionActive)
+            checkEngine(doubleFilterEngine);
+        
+        telemetry.addDenormalGuardHits(numFlushed);
+        
+        if (wasReset)
+        {
+            resetSignalPath();
+            mainBlock.clear();
+            telemetry.addStateReset();
+        }
+    }
+    
+    // Hand the result to the spectrum analyzer, if one is open.
+    analyzerFifo.push(mainBlock);
+    automationSplitter.endBlock(automatedSettings);
+}
+
+template <typename SampleType>
+void BasicEQAudioProcessor::processAutomated(juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& sidechain,
+                                             int subBlockSize, juce::uint32 generation)
+{
+    const auto numSegments = automationSplitter.beginBlock(static_cast<int>(block.getNumSamples()), automatedSettings);
+    
+    for (int i = 0; i < numSegments; ++i)
+    {
+        const auto& segment = automationSplitter.getSegment(i);
+        AutomationSplitter::ChangedParts changed;
+        
+        /* Each point is a step at the sample it falls on, just as the host drew it, so there's no glide. Only what the
+         * segment's changes touch is redesigned, and the coalescing in the splitter keeps that to one redesign per
+         * minimumSegmentLength samples at most.
+         */
+        if (automationSplitter.applySegment(i, automatedSettings, changed))
+        {
+            applyAutomatedChanges(changed);
+            telemetry.addCoefficientUpdate();
+        }
+        
+        const auto start = static_cast<size_t>(segment.start);
+        const auto length = static_cast<size_t>(segment.length);
+        auto segmentBlock = block.getSubBlock(start, length);
+        processFilters(segmentBlock, sidechain.getSubBlock(start, length), subBlockSize);
+    }
+    
+    automatedGeneration = generation;
+}
+
+template <typename SampleType>
+void BasicEQAudioProcessor::processFilters(juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& sidechain, int subBlockSize)
+{
+    /* The linear phase kernel is designed from the static settings, so dynamic bands only move in this mode.
+     * Without any, the whole block goes through in one go.
+     */
+    if (anyDynamicBands)
+        processDynamic(block, sidechain, subBlockSize);
+    else
+        processOversampled(block, subBlockSize);
+}
+
+template <typename SampleType>
+void BasicEQAudioProcessor::processOversampled(juce::dsp::AudioBlock<SampleType>& block, int subBlockSize)
+{
+    /* The oversampling factor follows the coefficients rather than the parameter, so the engine never runs
+     * coefficients designed for one rate at another while the pipeline catches up with a change.
+     */
+    const auto oversamplingIndex = juce::roundToInt(std::log2(chainCoefficients.sampleRate / getSampleRate()));
+    auto& slots = getOversamplerSlots<SampleType>();
+    auto* oversampler = getOversampler(slots, oversamplingIndex, chainCoefficients.oversamplingFilter);
+    
+    // The pipeline builds the oversampler before publishing a set that needs it, so this should never happen.
+    jassert(oversampler != nullptr || oversamplingIndex <= 0);
+    
+    if (oversampler != slots.activeOversampler)
+    {
+        slots.activeOversampler = oversampler;
+        resetFilters();
+        
+        // The ramp counts steps in samples at the engine's rate, which has just changed.
+        samplesUntilRampStep = 0;
+        
+        if (oversampler != nullptr)
+            oversampler->reset();
+    }
+    
+    if (oversampler == nullptr)
+    {
+        processMinimumPhase(block, subBlockSize);
+    }
+    else
+    {
+        // The oversamplers only have room for the block size promised in prepareToPlay(), so bigger blocks go in pieces.
+        for (size_t start = 0; start < block.getNumSamples(); start += maximumBlockSize)
+        {
+            auto chunk = block.getSubBlock(start, juce::jmin(maximumBlockSize, block.getNumSamples() - start));
+            auto oversampledBlock = oversampler->processSamplesUp(chunk);
+            processMinimumPhase(oversampledBlock, subBlockSize);
+            oversampler->processSamplesDown(chunk);
+        }
+    }
+}
+
+template <typename SampleType>
+void BasicEQAudioProcessor::processDynamic(juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& sidechain, int subBlockSize)
+{
+    /* Each chunk is measured first and then filtered with the gains that measurement gives, so a band reacts within
+     * dynamicStepSize samples. That's well under any attack time anyone would set, and keeps the redesigns cheap.
+     */
+    const auto numSamples = block.getNumSamples();
+    
+    for (size_t start = 0; start < numSamples; start += dynamicStepSize)
+    {
+        const auto length = juce::jmin(dynamicStepSize, numSamples - start);
+        auto chunk = block.getSubBlock(start, length);
+        
+        dynamicBandDetector.process(chunk, sidechain.getSubBlock(start, length));
+        updateDynamicBands();
+        processOversampled(chunk, subBlockSize);
+    }
+}
+
+void BasicEQAudioProcessor::prepareDynamicBands()
+{
+    dynamicBandDetector.setDesigns(chainCoefficients.dynamics);
+    
+    anyDynamicBands = std::any_of(chainCoefficients.dynamics.begin(), chainCoefficients.dynamics.end(),
+                                  [](const DynamicBandDesign& design) { return design.enabled; });
+    
+    updateDynamicBands();
+}
+
+void BasicEQAudioProcessor::updateDynamicBands()
+{
+    /* Only the gain moves, so each band is redesigned from the trig terms the pipeline already worked out.
+     * Frequency and Q changes on a dynamic band therefore take effect straight away, rather than gliding.
+     */
+    for (int i = 0; i < maxDynamicBands; ++i)
+    {
+        const auto& design = chainCoefficients.dynamics[static_cast<size_t>(i)];
+        
+        if (! design.enabled)
+            continue;
+        
+        auto& coefficients = dynamicBandCoefficients[static_cast<size_t>(i)];
+        coefficients = CoefficientDesign::makeBandForGain(design, dynamicBandDetector.getGainDecibels(i));
+        updateBandFilter(i, coefficients);
+    }
+}
+
+template <typename SampleType>
+void BasicEQAudioProcessor::processMinimumPhase(juce::dsp::AudioBlock<SampleType>& block, int subBlockSize)
+{
+    // Most of the time nothing is moving, so the whole buffer goes through the chains in one go.
+    if (! coefficientRamp.isRamping())
+    {
+        samplesUntilRampStep = 0;
+        processChains(block);
+        return;
+    }
+    
+    /* While a ramp is running, the coefficients take one step every subBlockSize samples. That's at most
+     * numSamples / subBlockSize updates per block, however dense the automation is. Dynamic bands, automation
+     * segments and oversampler chunks all hand this pieces of a block, often shorter than a step, so the count to
+     * the next step carries over between calls; otherwise every piece would start with a step of its own.
+     * The ramp can also have been started with smoothing since turned off; in that case it finishes in one step.
+     */
+    const auto numSamples = block.getNumSamples();
+    const auto stepSize = subBlockSize > 0 ? subBlockSize : static_cast<int>(numSamples);
+    
+    for (size_t start = 0; start < numSamples;)
+    {
+        if (samplesUntilRampStep <= 0)
+        {
+            updateFilters(coefficientRamp.advance());
+            samplesUntilRampStep = stepSize;
+        }
+        
+        // Once the last step is taken, the rest of the block goes through in one go.
+        if (! coefficientRamp.isRamping())
+        {
+            samplesUntilRampStep = 0;
+            auto rest = block.getSubBlock(start, numSamples - start);
+            processChains(rest);
+            return;
+        }
+        
+        const auto length = juce::jmin(static_cast<size_t>(samplesUntilRampStep), numSamples - start);
+        auto subBlock = block.getSubBlock(start, length);
+        processChains(subBlock);
+        
+        start += length;
+        samplesUntilRampStep -= static_cast<int>(length);
+    }
+}
+
+template <typename SampleType>
+void BasicEQAudioProcessor::processChains(juce::dsp::AudioBlock<SampleType>& block)
+{
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        if (mixedPrecisionActive)
+        {
+            /* The low cut and the bands near DC run on a double copy of the block, and the rest on the float block
+             * after that. The chain is linear, so running the sections in a different order gives the same result.
+             */
+            const auto chunkSize = static_cast<size_t>(mixedPrecisionBuffer.getNumSamples());
+            
+            for (size_t start = 0; start < block.getNumSamples(); start += chunkSize)
+            {
+                const auto numThisTime = juce::jmin(chunkSize, block.getNumSamples() - start);
+                auto chunk = block.getSubBlock(start, numThisTime);
+                auto doubleChunk = juce::dsp::AudioBlock<double>(mixedPrecisionBuffer)
+                                       .getSubsetChannelBlock(0, chunk.getNumChannels())
+                                       .getSubBlock(0, numThisTime);
+                
+                for (size_t channel = 0; channel < chunk.getNumChannels(); ++channel)
+                {
+                    auto* samples = chunk.getChannelPointer(channel);
+                    std::copy(samples, samples + numThisTime, doubleChunk.getChannelPointer(channel));
+                }
+                
+                doubleFilterEngine.process(doubleChunk);
+                
+                for (size_t channel = 0; channel < chunk.getNumChannels(); ++channel)
+                {
+                    const auto* samples = doubleChunk.getChannelPointer(channel);
+                    std::copy(samples, samples + numThisTime, chunk.getChannelPointer(channel));
+                }
+                
+                filterEngine.process(chunk);
+            }
+            
+            return;
+        }
+    }
+    
+    // The engine filters every channel of the main bus in a single pass.
+    getFilterEngine<SampleType>().process(block);
+}
+
+int BasicEQAudioProcessor::getSmoothingSubBlockSize(int smoothingChoice)
+{
+    // These line up with the "Smoothing" choices in createParameterLayout(); 0 means smoothing is off.
+    constexpr int subBlockSizes[] { 0, 16, 32, 64 };
+    return subBlockSizes[juce::jlimit(0, 3, smoothingChoice)];
+}
+
+template <typename SampleType>
+typename BasicEQAudioProcessor::OversamplerSlots<SampleType>::Oversampler*
+    BasicEQAudioProcessor::getOversampler(const OversamplerSlots<SampleType>& slots, int oversamplingIndex, int filterIndex) noexcept
+{
+    if (oversamplingIndex <= 0)
+        return nullptr;
+    
+    return slots.readyOversamplers[static_cast<size_t>(juce::jlimit(0, 1, filterIndex))]
+                            [static_cast<size_t>(juce::jmin(oversamplingIndex, 3) - 1)].load(std::memory_order_acquire);
+}
+
+int BasicEQAudioProcessor::getLatencyForSelectedMode() const noexcept
+{
+    if (isLinearPhaseSelected())
+        return linearPhaseConvolver.getLatencySamples();
+    
+    // The oversamplers are built with integer latency, so this rounding is exact.
+    auto getLatency = [this](const auto& slots)
+    {
+        if (auto* oversampler = getOversampler(slots, static_cast<int>(oversamplingParameter->load()),
+                                               static_cast<int>(oversamplingFilterParameter->load())))
+            return juce::roundToInt(oversampler->getLatencyInSamples());
+        
+        return 0;
+    };
+    
+    return isUsingDoublePrecision() ? getLatency(doubleOversamplers) : getLatency(floatOversamplers);
+}
+
+void BasicEQAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(getLatencyForSelectedMode());
+}
+
+//==============================================================================
+void BasicEQAudioProcessor::updateFilters(const ChainCoefficients& coefficients)
+{
+    // Each group of channels gets its own part of the one set.
+    std::array<ChannelSelection, 3> selections;
+    const auto numSelections = getChannelSelections(coefficients, selections);
+    
+    auto load = [&](auto& engine, auto stagesToRun)
+    {
+        for (int i = 0; i < numSelections; ++i)
+            engine.setCoefficients(coefficients, stagesToRun, selections[static_cast<size_t>(i)]);
+    };
+    
+    if (isUsingDoublePrecision())
+    {
+        load(doubleFilterEngine, MultichannelBiquadCascade<double>::Stages::all);
+    }
+    else if (! mixedPrecisionActive)
+    {
+        load(filterEngine, MultichannelBiquadCascade<float>::Stages::all);
+    }
+    else
+    {
+        /* A band moves between the engines as its poles cross the threshold, which happens while it's being swept.
+         * Its state moves with it, converted to the new precision, so it carries on exactly where it left off.
+         */
+        std::array<bool, maxBands> wasInDouble {}, wasInFloat {};
+        
+        for (int band = 0; band < maxBands; ++band)
+        {
+            wasInDouble[static_cast<size_t>(band)] = doubleFilterEngine.isBandActive(band);
+            wasInFloat[static_cast<size_t>(band)] = filterEngine.isBandActive(band);
+        }
+        
+        load(doubleFilterEngine, MultichannelBiquadCascade<double>::Stages::needingDoublePrecision);
+        load(filterEngine, MultichannelBiquadCascade<float>::Stages::notNeedingDoublePrecision);
+        
+        for (int band = 0; band < maxBands; ++band)
+        {
+            const auto inDouble = doubleFilterEngine.isBandActive(band);
+            const auto inFloat = filterEngine.isBandActive(band);
+            
+            if (wasInDouble[static_cast<size_t>(band)] && ! inDouble && inFloat)
+                for (int channel = 0; channel < filterEngine.getNumChannels(); ++channel)
+                    filterEngine.setBandState(band, channel, doubleFilterEngine.getBandState(band, channel));
+            
+            if (wasInFloat[static_cast<size_t>(band)] && ! inFloat && inDouble)
+                for (int channel = 0; channel < filterEngine.getNumChannels(); ++channel)
+                    doubleFilterEngine.setBandState(band, channel, filterEngine.getBandState(band, channel));
+        }
+    }
+    
+    // The static coefficients include the dynamic bands at their resting gain; put back where the detectors have them.
+    if (anyDynamicBands)
+        for (int i = 0; i < maxDynamicBands; ++i)
+            if (chainCoefficients.dynamics[static_cast<size_t>(i)].enabled)
+                updateBandFilter(i, dynamicBandCoefficients[static_cast<size_t>(i)]);
+}
+
+void BasicEQAudioProcessor::applyAutomatedChanges(const AutomationSplitter::ChangedParts& changed)
+{
+    using namespace CoefficientDesign;
+    
+    const auto sampleRate = chainCoefficients.sampleRate;
+    
+    /* Filters that move, switch on or off, or change length need the whole set loading again; the rest load in place.
+     * So does everything while a ramp is running, since the engines hold the ramp's coefficients, not these.
+     */
+    auto needsReload = changed.placements || coefficientRamp.isRamping();
+    
+    if (changed.placements)
+    {
+        chainCoefficients.lowCutPlacement = automatedSettings.lowCutPlacement;
+        chainCoefficients.highCutPlacement = automatedSettings.highCutPlacement;
+        
+        for (int i = 0; i < maxBands; ++i)
+            chainCoefficients.bandPlacements[static_cast<size_t>(i)] = automatedSettings.bands[static_cast<size_t>(i)].placement;
+    }
+    
+    if (changed.lowCut)
+    {
+        const auto numSections = getNumCutSections(automatedSettings.lowCutSlope);
+        needsReload = needsReload || numSections != chainCoefficients.numLowCutSections;
+        chainCoefficients.numLowCutSections = numSections;
+        makeLowCut(sampleRate, automatedSettings.lowCutFrequency, numSections, chainCoefficients.lowCut.data());
+    }
+    
+    if (changed.highCut)
+    {
+        const auto numSections = getNumCutSections(automatedSettings.highCutSlope);
+        needsReload = needsReload || numSections != chainCoefficients.numHighCutSections;
+        chainCoefficients.numHighCutSections = numSections;
+        makeHighCut(sampleRate, automatedSettings.highCutFrequency, numSections, chainCoefficients.highCut.data());
+    }
+    
+    for (int i = 0; i < maxBands; ++i)
+    {
+        if (((changed.bands >> i) & 1) == 0)
+            continue;
+        
+        // Bands past the count are pass-throughs, as in makeChainCoefficients().
+        auto& band = chainCoefficients.bands[static_cast<size_t>(i)];
+        const auto designed = i < automatedSettings.numBands ? makeBand(sampleRate, automatedSettings.bands[static_cast<size_t>(i)])
+                                                             : BiquadCoefficients {};
+        
+        // In mixed precision, a band also moves between the engines as its poles cross the threshold.
+        needsReload = needsReload
+                   || isPassThrough(designed) != isPassThrough(band)
+                   || (mixedPrecisionActive && needsDoublePrecision(designed) != needsDoublePrecision(band));
+        band = designed;
+    }
+    
+    for (int i = 0; i < maxDynamicBands; ++i)
+        if ((changed.dynamics >> i) & 1)
+            chainCoefficients.dynamics[static_cast<size_t>(i)] = makeDynamicBand(sampleRate, getSampleRate(),
+                                                                                 automatedSettings.bands[static_cast<size_t>(i)]);
+    
+    coefficientRamp.reset(chainCoefficients);
+    
+    if (needsReload)
+    {
+        updateFilters(chainCoefficients);
+    }
+    else
+    {
+        if (changed.lowCut || changed.highCut)
+        {
+            if (isUsingDoublePrecision() || mixedPrecisionActive)
+                doubleFilterEngine.setCutCoefficients(chainCoefficients, changed.lowCut, changed.highCut);
+            
+            if (! isUsingDoublePrecision())
+                filterEngine.setCutCoefficients(chainCoefficients, changed.lowCut, changed.highCut);
+        }
+        
+        for (int i = 0; i < maxBands; ++i)
+            if ((changed.bands >> i) & 1)
+                updateBandFilter(i, chainCoefficients.bands[static_cast<size_t>(i)]);
+    }
+    
+    // This puts any dynamic band back where its detector has it, over the static coefficients just loaded.
+    if (changed.dynamics != 0)
+        prepareDynamicBands();
+}
+
+void BasicEQAudioProcessor::updateBandFilter(int band, const BiquadCoefficients& coefficients)
+{
+    // Each engine only takes coefficients for bands it's running, so in mixed precision, only one of these does anything.
+    if (isUsingDoublePrecision() || mixedPrecisionActive)
+        doubleFilterEngine.setBandCoefficients(band, coefficients);
+    
+    if (! isUsingDoublePrecision())
+        filterEngine.setBandCoefficients(band, coefficients);
+}
+
+void BasicEQAudioProcessor::resetFilters()
+{
+    filterEngine.reset();
+    doubleFilterEngine.reset();
+}
+
+void BasicEQAudioProcessor::resetSignalPath()
+{
+    resetFilters();
+    dynamicBandDetector.reset();
+    linearPhaseConvolver.reset();
+    
+    if (floatOversamplers.activeOversampler != nullptr)
+        floatOversamplers.activeOversampler->reset();
+    
+    if (doubleOversamplers.activeOversampler != nullptr)
+        doubleOversamplers.activeOversampler->reset();
+}
+
+bool BasicEQAudioProcessor::applyChannelMode()
+{
+    const auto mode = getSelectedChannelMode();
+    
+    if (mode == activeChannelMode)
+        return false;
+    
+    // Every filter may have moved to different channels, so they all start again, wherever they are now.
+    activeChannelMode = mode;
+    filterEngine.setMidSide(mode == ChannelMode::midSide);
+    doubleFilterEngine.setMidSide(mode == ChannelMode::midSide);
+    resetFilters();
+    
+    return true;
+}
+
+int BasicEQAudioProcessor::getChannelSelections(const ChainCoefficients& coefficients,
+                                                std::array<ChannelSelection, 3>& selections) const noexcept
+{
+    if (activeChannelMode == ChannelMode::linked)
+    {
+        selections[0] = {};
+        return 1;
+    }
+    
+    /* Left/Right and Mid/Side split the first two channels; the engines put mid and side where left and right were.
+     * Whatever's left over, like the rest of a surround bus, only runs the filters that are on all channels.
      */
+    const auto allChannels = (1u << filterEngine.getNumChannels()) - 1;
+    const auto frontRear = activeChannelMode == ChannelMode::frontRear;
+    const auto firstGroup = (frontRear ? frontChannels : 1u) & allChannels;
+    const auto secondGroup = (frontRear ? ~frontChannels : 2u) & allChannels;
     
-    // First the block; initialized for processing floats.
-    juce::dsp::AudioBlock<float> block(buffer);
+    const std::pair<juce::uint32, ChannelPlacement> groups[]
+    {
+        { firstGroup, ChannelPlacement::firstGroup },
+        { secondGroup, ChannelPlacement::secondGroup },
+        { allChannels & ~(firstGroup | secondGroup), ChannelPlacement::all }
+    };
     
-    // Now we can use helper functions to extract individual channels, wrapped in their own blocks.
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    auto numSelections = 0;
     
-    // Now we set up our processing contexts for each channel's block.
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    for (const auto& [channels, placement] : groups)
+    {
+        if (channels == 0)
+            continue;
+        
+        auto runsHere = [placement = placement](ChannelPlacement filterPlacement)
+        {
+            return filterPlacement == ChannelPlacement::all || filterPlacement == placement;
+        };
+        
+        auto& selection = selections[static_cast<size_t>(numSelections++)];
+        selection.channels = channels;
+        selection.bands = 0;
+        selection.lowCut = runsHere(coefficients.lowCutPlacement);
+        selection.highCut = runsHere(coefficients.highCutPlacement);
+        
+        for (int band = 0; band < maxBands; ++band)
+            if (runsHere(coefficients.bandPlacements[static_cast<size_t>(band)]))
+                selection.bands |= 1u << band;
+    }
     
-    // Now we provide these contexts to the filter chains.
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    return numSelections;
+}
+
+bool BasicEQAudioProcessor::applyFilterTopology()
+{
+    using FloatTopology = MultichannelBiquadCascade<float>::Topology;
+    using DoubleTopology = MultichannelBiquadCascade<double>::Topology;
+    
+    const auto stateVariable = isStateVariableSelected();
+    
+    // The engines are always switched together, so the float one speaks for both.
+    if ((filterEngine.getTopology() == FloatTopology::stateVariable) == stateVariable)
+        return false;
+    
+    filterEngine.setTopology(stateVariable ? FloatTopology::stateVariable : FloatTopology::transposedDirectForm2);
+    doubleFilterEngine.setTopology(stateVariable ? DoubleTopology::stateVariable : DoubleTopology::transposedDirectForm2);
+    return true;
+}
+
+template <typename SampleType>
+bool BasicEQAudioProcessor::isSilent(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    const auto threshold = static_cast<SampleType>(silenceThreshold);
+    
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(block.getChannelPointer(channel),
+                                                                      static_cast<int>(block.getNumSamples()));
+        
+        // Written this way round so that a NaN, which fails every comparison, doesn't count as silence.
+        if (! (range.getStart() >= -threshold && range.getEnd() <= threshold))
+            return false;
+    }
+    
+    return true;
+}
+
+juce::int64 BasicEQAudioProcessor::getSilenceHoldSamples() const noexcept
+{
+    // Whatever went in before the silence has to come out through the latency, and then ring out for the tail.
+    const auto tailSamples = static_cast<juce::int64>(std::ceil(getTailLengthSeconds() * getSampleRate()));
+    return tailSamples + getLatencySamples();
 }
 
 //==============================================================================
@@ -228,24 +1080,135 @@ bool BasicEQAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* BasicEQAudioProcessor::createEditor()
 {
-    //return new BasicEQAudioProcessorEditor (*this);
-    
-    // Before we've added our parameters to the GUI, we can use an Audio Processor Editor to view and edit them.
-    return new juce::GenericAudioProcessorEditor(*this);
+    return new BasicEQAudioProcessorEditor (*this);
 }
 
 //==============================================================================
 void BasicEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // Hosts call this for every autosave and undo snapshot, so it writes our compact binary format rather than XML.
+    parameterState.write(destData);
 }
 
 void BasicEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    // Anything that isn't one of our states (including the empty state older versions saved) is ignored.
+    applyState(data, static_cast<size_t>(juce::jmax(0, sizeInBytes)));
+}
+
+bool BasicEQAudioProcessor::applyState(const void* data, size_t sizeInBytes)
+{
+    const CoefficientPipeline::ScopedBatch batch(coefficientPipeline);
+    return parameterState.apply(data, sizeInBytes);
+}
+
+bool BasicEQAudioProcessor::loadPresetBank(const juce::File& file)
+{
+    return presetBank.open(file);
+}
+
+bool BasicEQAudioProcessor::recallPreset(int index)
+{
+    const auto state = presetBank.getPresetState(index);
+    return state.data != nullptr && applyState(state.data, state.size);
+}
+
+juce::String getBandParameterPrefix(int bandIndex)
+{
+    return "Band " + juce::String(bandIndex + 1) + " ";
+}
+
+namespace
+{
+    /* Every band has eleven parameters, and both the layout and getChainSettings() look each of them up by ID, so
+     * building the IDs from scratch every time adds up to hundreds of small allocations per design and per instance.
+     * They never change, so they're built once for the whole process instead.
+     */
+    struct BandParameterIDs
+    {
+        juce::String type, frequency, gain, quality, channels;
+        juce::String dynamic, threshold, ratio, attack, release, sidechain;
+    };
+    
+    const BandParameterIDs& getBandParameterIDs(int bandIndex)
+    {
+        static const auto allIDs = []
+        {
+            std::array<BandParameterIDs, maxBands> ids;
+            
+            for (int i = 0; i < maxBands; ++i)
+            {
+                const auto prefix = getBandParameterPrefix(i);
+                auto& band = ids[static_cast<size_t>(i)];
+                
+                band.type      = prefix + "Type";
+                band.frequency = prefix + "Freq";
+                band.gain      = prefix + "Gain";
+                band.quality   = prefix + "Quality";
+                band.channels  = prefix + "Channels";
+                band.dynamic   = prefix + "Dynamic";
+                band.threshold = prefix + "Threshold";
+                band.ratio     = prefix + "Ratio";
+                band.attack    = prefix + "Attack";
+                band.release   = prefix + "Release";
+                band.sidechain = prefix + "Sidechain";
+            }
+            
+            return ids;
+        }();
+        
+        return allIDs[static_cast<size_t>(bandIndex)];
+    }
+    
+    /* The option lists for every choice parameter. Each instance's layout copies them, which only shares the strings,
+     * so like the IDs they're built once for the whole process.
+     */
+    struct ChoiceStrings
+    {
+        juce::StringArray bandTypes, channelPlacements, slopes, channelModes, smoothing;
+        juce::StringArray phaseModes, oversampling, oversamplingFilters, topologies, precisions;
+    };
+    
+    const ChoiceStrings& getChoiceStrings()
+    {
+        static const auto strings = []
+        {
+            ChoiceStrings choices;
+            
+            choices.bandTypes = {"Off", "Bell", "Low Shelf", "High Shelf", "Notch", "Tilt", "Band Pass"};
+            
+            // The groups of channels a filter can be placed on; which channels they are depends on the "Channel Mode".
+            choices.channelPlacements = {"All", "Left / Mid / Front", "Right / Side / Rear"};
+            
+            /* Filter Array: AudioParameterChoice objects use an array to store the options.
+             * Due to how the math works out (still learning about this) you want the slopes of
+             * high / low pass filters to be factors of 6 or 12 dB/Oct for best results.
+             */
+            for(int i = 0; i < 4; ++i) {
+                juce::String str;
+                // Start at 12dB, then 24dB, then 36dB...
+                str << (12 + i*12);
+                // Concat " db/Oct" to the end of the string; C++ overloads << and >>, making them tools for working w/ strings & streams.
+                str << " dB/Oct";
+                choices.slopes.add(str);
+            }
+            
+            // One extra, much steeper option for surgical cuts; this uses 8 filters instead of 4.
+            choices.slopes.add("96 dB/Oct");
+            
+            choices.channelModes        = {"Linked", "Left/Right", "Mid/Side", "Front/Rear"};
+            choices.smoothing           = {"Off", "16 Samples", "32 Samples", "64 Samples"};
+            choices.phaseModes          = {"Minimum Phase", "Linear Phase"};
+            choices.oversampling        = {"Off", "2x", "4x", "8x"};
+            choices.oversamplingFilters = {"Polyphase IIR", "Linear Phase FIR"};
+            choices.topologies          = {"Direct Form II", "State Variable"};
+            choices.precisions          = {"Float", "Mixed"};
+            
+            return choices;
+        }();
+        
+        return strings;
+    }
 }
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) {
@@ -258,15 +1221,79 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) {
     
     settings.lowCutFrequency  = apvts.getRawParameterValue("LowCut Freq")->load();
     settings.highCutFrequency = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFrequency    = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGainDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality      = apvts.getRawParameterValue("Peak Quality")->load();
     settings.lowCutSlope      = apvts.getRawParameterValue("LowCut Slope")->load();
     settings.highCutSlope     = apvts.getRawParameterValue("HighCut Slope")->load();
+    settings.lowCutPlacement  = static_cast<ChannelPlacement>(static_cast<int>(apvts.getRawParameterValue("LowCut Channels")->load()));
+    settings.highCutPlacement = static_cast<ChannelPlacement>(static_cast<int>(apvts.getRawParameterValue("HighCut Channels")->load()));
+    settings.oversampling     = apvts.getRawParameterValue("Oversampling")->load();
+    settings.oversamplingFilter = apvts.getRawParameterValue("Oversampling Filter")->load();
+    settings.numBands         = static_cast<int>(apvts.getRawParameterValue("Band Count")->load());
+    
+    for (int i = 0; i < maxBands; ++i)
+    {
+        auto& band = settings.bands[static_cast<size_t>(i)];
+        const auto& ids = getBandParameterIDs(i);
+        
+        band.type         = static_cast<BandType>(static_cast<int>(apvts.getRawParameterValue(ids.type)->load()));
+        band.frequency    = apvts.getRawParameterValue(ids.frequency)->load();
+        band.gainDecibels = apvts.getRawParameterValue(ids.gain)->load();
+        band.quality      = apvts.getRawParameterValue(ids.quality)->load();
+        band.placement    = static_cast<ChannelPlacement>(static_cast<int>(apvts.getRawParameterValue(ids.channels)->load()));
+        
+        if (i < maxDynamicBands)
+        {
+            band.dynamic             = apvts.getRawParameterValue(ids.dynamic)->load() > 0.5f;
+            band.thresholdDecibels   = apvts.getRawParameterValue(ids.threshold)->load();
+            band.ratio               = apvts.getRawParameterValue(ids.ratio)->load();
+            band.attackMilliseconds  = apvts.getRawParameterValue(ids.attack)->load();
+            band.releaseMilliseconds = apvts.getRawParameterValue(ids.release)->load();
+            band.useSidechain        = apvts.getRawParameterValue(ids.sidechain)->load() > 0.5f;
+        }
+    }
     
     return settings;
 }
 
+void BasicEQAudioProcessor::addAutomationTargets()
+{
+    using Field = AutomationSplitter::Field;
+    
+    auto addTarget = [this](const juce::String& parameterID, Field field, int band = 0)
+    {
+        automationSplitter.addTarget(*apvts.getParameter(parameterID), *apvts.getRawParameterValue(parameterID), field, band);
+    };
+    
+    // Everything getChainSettings() reads, apart from the oversampling choices, which aren't automatable.
+    addTarget("LowCut Freq", Field::lowCutFrequency);
+    addTarget("HighCut Freq", Field::highCutFrequency);
+    addTarget("LowCut Slope", Field::lowCutSlope);
+    addTarget("HighCut Slope", Field::highCutSlope);
+    addTarget("LowCut Channels", Field::lowCutPlacement);
+    addTarget("HighCut Channels", Field::highCutPlacement);
+    addTarget("Band Count", Field::numBands);
+    
+    for (int i = 0; i < maxBands; ++i)
+    {
+        const auto& ids = getBandParameterIDs(i);
+        
+        addTarget(ids.type, Field::bandType, i);
+        addTarget(ids.frequency, Field::bandFrequency, i);
+        addTarget(ids.gain, Field::bandGain, i);
+        addTarget(ids.quality, Field::bandQuality, i);
+        addTarget(ids.channels, Field::bandPlacement, i);
+        
+        if (i < maxDynamicBands)
+        {
+            addTarget(ids.dynamic, Field::bandDynamic, i);
+            addTarget(ids.threshold, Field::bandThreshold, i);
+            addTarget(ids.ratio, Field::bandRatio, i);
+            addTarget(ids.attack, Field::bandAttack, i);
+            addTarget(ids.release, Field::bandRelease, i);
+            addTarget(ids.sidechain, Field::bandSidechain, i);
+        }
+    }
+}
+
 juce::AudioProcessorValueTreeState::ParameterLayout
     BasicEQAudioProcessor::createParameterLayout()
 {
@@ -288,57 +1315,194 @@ juce::AudioProcessorValueTreeState::ParameterLayout
                                                                juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f),
                                                                20000.f));
         
-        /* Peak Frequency - Adjust decibels around a certain frequency.
-         * Range: 20Hz - 20,000Hz. Incremented by 1Hz, no skew. Default value of 750Hz
+        /* Band Count - How many parametric bands are on offer, from 8 to 24. Bands past the count are off.
+         * Every band's parameters always exist, so hosts see a fixed parameter list whatever the count.
          */
-        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {"Peak Freq", 1},
-                                                               "Peak Freq",
-                                                               juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f),
-                                                               750.f));
+        layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID {"Band Count", 1},
+                                                             "Band Count",
+                                                             minBands, maxBands, minBands));
         
-        /* Peak Gain - The amount to adjust the decibels around our peak frequency.
-         * Range: -24dB to 24dB. Incremented by 0.1dB, no skew. Default value of 0dB (flat)
-         */
-        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {"Peak Gain", 1},
-                                                               "Peak Gain",
-                                                               juce::NormalisableRange<float>(-24.f, 24.f, 0.1f, 1.f),
-                                                               0.0f));
+        const auto& choices = getChoiceStrings();
         
-        /* Peak Quality - The "width" of the peak. A higher quality represents a thinner peak.
-         * Range: 0.1 to 10. Incremented by 0.1, no skew. Default value of 1.
-         */
-        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {"Peak Quality", 1},
-                                                               "Peak Quality",
-                                                               juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
-                                                               1.f));
-        
-        /* Filter Array: AudioParameterChoice objects use an array to store the options.
-         * Due to how the math works out (still learning about this) you want the slopes of
-         * high / low pass filters to be factors of 6 or 12 dB/Oct for best results.
-         */
-        juce::StringArray filterArray;
-        for(int i = 0; i < 4; ++i) {
-            juce::String str;
-            // Start at 12dB, then 24dB, then 36dB...
-            str << (12 + i*12);
-            // Concat " db/Oct" to the end of the string; C++ overloads << and >>, making them tools for working w/ strings & streams.
-            str << " dB/Oct";
-            filterArray.add(str);
+        for (int i = 0; i < maxBands; ++i)
+        {
+            const auto& ids = getBandParameterIDs(i);
+            
+            /* Band N Type - The shape of the band; see BandType. Every band starts out as a bell.
+             * A bell, shelf or tilt with 0dB of gain does nothing, and costs nothing.
+             */
+            layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {ids.type, 1},
+                                                                    ids.type,
+                                                                    choices.bandTypes, static_cast<int>(BandType::bell)));
+            
+            /* Band N Freq - The centre (or corner) frequency of the band.
+             * Range: 20Hz - 20,000Hz. Incremented by 1Hz, no skew. The first band starts at 750Hz, where the old
+             * single peak did; the others are spread out evenly on a log scale so they're ready to use.
+             */
+            const auto defaultFrequency = i == 0 ? 750.f
+                                                 : static_cast<float>(juce::roundToInt(30.0 * std::pow(500.0, i / static_cast<double>(maxBands - 1))));
+            
+            layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {ids.frequency, 1},
+                                                                   ids.frequency,
+                                                                   juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f),
+                                                                   defaultFrequency));
+            
+            /* Band N Gain - How far the band boosts or cuts. Notch and band pass ignore it.
+             * Range: -24dB to 24dB. Incremented by 0.1dB, no skew. Default value of 0dB (flat)
+             */
+            layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {ids.gain, 1},
+                                                                   ids.gain,
+                                                                   juce::NormalisableRange<float>(-24.f, 24.f, 0.1f, 1.f),
+                                                                   0.0f));
+            
+            /* Band N Quality - The "width" of the band. A higher quality represents a thinner band, or a steeper shelf.
+             * Range: 0.1 to 10. Incremented by 0.05, no skew. Default value of 1.
+             */
+            layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {ids.quality, 1},
+                                                                   ids.quality,
+                                                                   juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
+                                                                   1.f));
+            
+            /* Band N Channels - Which channels the band runs on; see "Channel Mode". Every band starts out on all of them.
+             * In linear phase mode, and with the channels linked, every band runs on every channel.
+             */
+            layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {ids.channels, 1},
+                                                                    ids.channels,
+                                                                    choices.channelPlacements, static_cast<int>(ChannelPlacement::all)));
+            
+            // The first few bells, shelves and tilts can also be dynamic.
+            if (i >= maxDynamicBands)
+                continue;
+            
+            /* Band N Dynamic - Whether the band's gain follows the level in its part of the spectrum.
+             * Above the threshold, the gain is pulled down the way a compressor would pull the level down.
+             */
+            layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID {ids.dynamic, 1},
+                                                                  ids.dynamic,
+                                                                  false));
+            
+            /* Band N Threshold - The level, in the band, where it starts to react.
+             * Range: -60dB to 0dB. Incremented by 0.1dB, no skew. Default value of -18dB.
+             */
+            layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {ids.threshold, 1},
+                                                                   ids.threshold,
+                                                                   juce::NormalisableRange<float>(-60.f, 0.f, 0.1f, 1.f),
+                                                                   -18.f));
+            
+            /* Band N Ratio - How hard the gain is pulled down; at 4:1, every 4dB over the threshold takes 3dB off.
+             * Range: 1 to 20. Incremented by 0.1, skewed towards the low end. Default value of 2.
+             */
+            layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {ids.ratio, 1},
+                                                                   ids.ratio,
+                                                                   juce::NormalisableRange<float>(1.f, 20.f, 0.1f, 0.4f),
+                                                                   2.f));
+            
+            /* Band N Attack / Release - How quickly the detector follows rising and falling levels.
+             * Range: 0.1ms to 200ms and 5ms to 2000ms, skewed towards the fast end. Defaults of 5ms and 100ms.
+             */
+            layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {ids.attack, 1},
+                                                                   ids.attack,
+                                                                   juce::NormalisableRange<float>(0.1f, 200.f, 0.1f, 0.4f),
+                                                                   5.f));
+            
+            layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID {ids.release, 1},
+                                                                   ids.release,
+                                                                   juce::NormalisableRange<float>(5.f, 2000.f, 1.f, 0.4f),
+                                                                   100.f));
+            
+            /* Band N Sidechain - Listen to the sidechain bus rather than the input. With no sidechain connected,
+             * the band listens to the input either way.
+             */
+            layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID {ids.sidechain, 1},
+                                                                  ids.sidechain,
+                                                                  false));
         }
         
         /* Low Cut Slope - The slope for our low cut filter.
-         * Uses the filterArray to choose options and has a default starting index of 0 (12 dB/Oct).
+         * Uses the slope options to choose from and has a default starting index of 0 (12 dB/Oct).
          */
         layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"LowCut Slope", 1},
                                                                 "LowCut Slope",
-                                                                filterArray, 0));
+                                                                choices.slopes, 0));
         
         /* High Cut Slope - The slope for our high cut filter.
-         * Uses the filterArray to choose options and has a default starting index of 0 (12 dB/Oct).
+         * Uses the slope options to choose from and has a default starting index of 0 (12 dB/Oct).
          */
         layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"HighCut Slope", 1},
                                                                 "HighCut Slope",
-                                                                filterArray, 0));
+                                                                choices.slopes, 0));
+        
+        // LowCut Channels / HighCut Channels - Which channels each cut runs on, as for the bands.
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"LowCut Channels", 1},
+                                                                "LowCut Channels",
+                                                                choices.channelPlacements, static_cast<int>(ChannelPlacement::all)));
+        
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"HighCut Channels", 1},
+                                                                "HighCut Channels",
+                                                                choices.channelPlacements, static_cast<int>(ChannelPlacement::all)));
+        
+        /* Channel Mode - How the bus is split into the two groups of channels filters can be placed on. Linked runs every
+         * filter on every channel. Left/Right and Mid/Side split the first two channels, with mid and side encoded on the
+         * way in and decoded on the way out; Front/Rear splits a surround bus into its front and everything else. Any
+         * channel outside both groups only runs the filters placed on all channels. Switching restarts the filters, so
+         * it isn't automatable.
+         */
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"Channel Mode", 1},
+                                                                "Channel Mode",
+                                                                choices.channelModes, 0,
+                                                                juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+        
+        /* Smoothing - How finely coefficient changes are spread out over time.
+         * Each new coefficient set is reached over about 50ms in steps of this many samples; smaller steps are smoother
+         * but cost more. "Off" applies changes as a step at the start of the next block.
+         */
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"Smoothing", 1},
+                                                                "Smoothing",
+                                                                choices.smoothing, 2));
+        
+        /* Phase Mode - Minimum phase runs the IIR filters, linear phase runs the same curve as an FIR with no phase
+         * shift, at the cost of latency (about 90ms at 48kHz). Changing the latency mid-playback upsets most hosts,
+         * so this isn't automatable.
+         */
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"Phase Mode", 1},
+                                                                "Phase Mode",
+                                                                choices.phaseModes, 0,
+                                                                juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+        
+        /* Oversampling - Runs the filters at 2, 4 or 8 times the sample rate, so the curve near 20kHz comes out the
+         * same as it would at 96kHz. 4x with the polyphase IIR filters costs little enough to leave on all the time.
+         * Only used in minimum phase mode. Like the phase mode, these change the latency, so they aren't automatable.
+         */
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"Oversampling", 1},
+                                                                "Oversampling",
+                                                                choices.oversampling, 2,
+                                                                juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+        
+        /* Oversampling Filter - Polyphase IIR half-band filters only add a few samples of latency, but bend the phase
+         * near Nyquist. Equiripple FIR ones are linear phase, with more latency and CPU.
+         */
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"Oversampling Filter", 1},
+                                                                "Oversampling Filter",
+                                                                choices.oversamplingFilters, 0,
+                                                                juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+        
+        /* Filter Topology - How each section of the chain is computed. Direct Form II is the cheapest. State Variable
+         * gives the same curve with far less noise and drift for cuts and shelves at low frequencies, especially at
+         * high rates or with oversampling, for a little more CPU. Switching restarts the filters, so it isn't automatable.
+         */
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"Filter Topology", 1},
+                                                                "Filter Topology",
+                                                                choices.topologies, 0,
+                                                                juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+        
+        /* Precision - Float runs the whole chain in float. Mixed keeps float in and out, but runs the low cut and any
+         * band close to DC in double, which is where float runs out of precision at low frequencies and high rates.
+         * Hosts that process in double get double throughout, whatever this is set to.
+         */
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID {"Precision", 1},
+                                                                "Precision",
+                                                                choices.precisions, 0,
+                                                                juce::AudioParameterChoiceAttributes().withAutomatable(false)));
         
         // These parameters are all added to our APVTS by the createParameterLayout call in PluginProcessor.h
     
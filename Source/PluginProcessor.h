@@ -9,26 +9,77 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AnalyzerFifo.h"
+#include "AutomationSplitter.h"
+#include "CallbackTelemetry.h"
+#include "CoefficientPipeline.h"
+#include "CoefficientRamp.h"
+#include "DynamicBandDetector.h"
+#include "LinearPhaseConvolver.h"
+#include "MultichannelBiquadCascade.h"
+#include "ParameterState.h"
+#include "PresetBank.h"
+
+// The shapes a parametric band can take, in the order of the "Band N Type" choices.
+enum class BandType
+{
+    off,
+    bell,
+    lowShelf,
+    highShelf,
+    notch,
+    tilt,
+    bandPass
+};
+
+struct BandSettings
+{
+    BandType type { BandType::off };
+    float frequency { 1000.f };
+    float gainDecibels { 0 };
+    float quality { 1.f };
+    
+    // Which channels the band runs on; see ChannelPlacement.
+    ChannelPlacement placement { ChannelPlacement::all };
+    
+    /* Dynamic EQ; only the first maxDynamicBands bands have these parameters. Above the threshold, the band's gain is
+     * pulled down as a compressor's would be, by (level - threshold) * (1 - 1 / ratio) decibels.
+     */
+    bool dynamic { false };
+    float thresholdDecibels { 0 };
+    float ratio { 1.f };
+    float attackMilliseconds { 10.f };
+    float releaseMilliseconds { 100.f };
+    bool useSidechain { false };
+};
 
 // A structure to hold settings for a processing chain.
 struct ChainSettings
 {
-    float peakFrequency { 0 };
-    float peakGainDecibels { 0 };
-    float peakQuality { 1.f };
+    // Only the first numBands are in use; the rest are treated as off.
+    std::array<BandSettings, maxBands> bands;
+    int numBands { minBands };
     float lowCutFrequency { 0 };
     float highCutFrequency { 0 };
     int lowCutSlope { 0 };
     int highCutSlope { 0 };
+    ChannelPlacement lowCutPlacement { ChannelPlacement::all };
+    ChannelPlacement highCutPlacement { ChannelPlacement::all };
+    int oversampling { 0 };
+    int oversamplingFilter { 0 };
 };
 
 // A function to return a settings struct, given an APVTS.
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
+// The start of every parameter ID for a band, counting from 0: "Band 1 ", "Band 2 " and so on.
+juce::String getBandParameterPrefix(int bandIndex);
+
 //==============================================================================
 /**
 */
-class BasicEQAudioProcessor  : public juce::AudioProcessor
+class BasicEQAudioProcessor  : public juce::AudioProcessor,
+                               private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -48,6 +99,12 @@ public:
      * If this is interrupted, it can cause pops or other problems.
      */
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    
+    /* Hosts that work in double can hand us double buffers, and then the whole IIR chain runs in double.
+     * The "Precision" parameter only applies to float buffers.
+     */
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -75,37 +132,327 @@ public:
     // Static because it does not use any member variables; this provides a list of all the parameters for the APVTS.
     static juce::AudioProcessorValueTreeState::ParameterLayout
         createParameterLayout();
+    
+    /* How long this instance took to construct, and how long its last prepareToPlay() took, in milliseconds.
+     * Hosts do both for every instance as a session loads, so these add up to the plugin's share of the load time.
+     */
+    struct StartupTiming
+    {
+        double constructionMilliseconds { 0.0 };
+        double prepareMilliseconds { 0.0 };
+    };
+    
+    StartupTiming getStartupTiming() const noexcept { return { constructionMilliseconds.load(), prepareMilliseconds.load() }; }
+    
+    /* Sample-accurate automation, for a wrapper or tool that knows where in the next block each change falls.
+     * Set the parameter to its value at the end of the block as usual, then queue each point along the way here,
+     * with its sample offset and normalised value, before calling processBlock(). Returns false if the parameter
+     * can't be automated this way, or too many changes have been queued. Audio thread only; real-time safe.
+     * See AutomationSplitter.
+     */
+    bool addParameterChange(int parameterIndex, int sampleOffset, float normalisedValue) noexcept
+    {
+        return automationSplitter.addChange(parameterIndex, sampleOffset, normalisedValue);
+    }
+    
+private:
+    // Taken before any other member is built, so the construction time covers the APVTS and everything after it.
+    const double constructionStartTime {juce::Time::getMillisecondCounterHiRes()};
+    std::atomic<double> constructionMilliseconds {0.0}, prepareMilliseconds {0.0};
+    
+public:
     // This is the APVTS
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
     
-    // Here we will declare some type aliases to simplify namespaces & definitions.
+    /* Callback timing and counters, for the editor's readout or anyone else who wants them.
+     * Only collected when the plugin is built with BASICEQ_TELEMETRY=1; otherwise the snapshot is always empty.
+     */
+    CallbackTelemetry& getTelemetry() noexcept { return telemetry; }
+    
+    // The processed signal, for the editor's spectrum analyzer.
+    AnalyzerFifo& getAnalyzerFifo() noexcept { return analyzerFifo; }
+    
+    /* Presets. A bank is memory-mapped when it's loaded, so recalling a preset from it, for A/B comparison say,
+     * only reads the values straight out of the mapping. All of these are for the message thread.
+     */
+    bool loadPresetBank(const juce::File& file);
+    int getNumPresets() const noexcept { return presetBank.getNumPresets(); }
+    juce::String getPresetName(int index) const { return presetBank.getPresetName(index); }
+    bool recallPreset(int index);
+    
 private:
     
-    /* This is a filter alias for processing floats. The filters in the IIR class have a response of 12dB/oct when
-     * configured as a low / high pass filter.
+    /* This represents the whole signal path; a high pass filter, up to 24 parametric bands, and a low pass filter.
+     * Rather than one scalar chain per channel, a single engine runs the chain over every channel of the bus
+     * at once, with one channel in each SIMD lane. The filter type is still 12dB/oct per biquad, so the cut
+     * filters use up to 4 biquads each for 48dB/oct, or 8 for 96dB/oct.
      */
-    using Filter = juce::dsp::IIR::Filter<float>;
+    MultichannelBiquadCascade<float> filterEngine;
     
-    /* This is an alias for a chain of 4 of the above filters; you need one filter per 12dB, so a chain of 4 filters
-     * = a shift of 48dB/oct.
-     * These aliases are flexible and could be used for a variety of different filters.
+    /* The same engine in double. It runs the whole chain for double buffers; for float buffers with "Precision" set to
+     * mixed, it runs just the low cut and the bands near DC, whose poles float can't place accurately, while the float
+     * engine runs everything else. Either way the coefficients come from the same set.
      */
-    using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+    MultichannelBiquadCascade<double> doubleFilterEngine;
+    
+    // Mixed precision converts each block to double for the double engine and back; this holds the double copy.
+    juce::AudioBuffer<double> mixedPrecisionBuffer;
+    
+    std::atomic<float>* precisionParameter {apvts.getRawParameterValue("Precision")};
+    
+    // Whether processBlock() is currently splitting float blocks between the engines; only touched on the audio thread.
+    bool mixedPrecisionActive {false};
+    
+    bool isMixedPrecisionSelected() const noexcept { return precisionParameter->load() > 0.5f; }
+    
+    std::atomic<float>* topologyParameter {apvts.getRawParameterValue("Filter Topology")};
     
-    /* This chain represents the whole mono signal path; a high pass filter, a peak filter, and a low pass filter.
-     * For stereo processing, we can use 2 instances of this mono chain.
+    bool isStateVariableSelected() const noexcept { return topologyParameter->load() > 0.5f; }
+    
+    /* Puts both engines into the topology "Filter Topology" asks for. Returns true if that was a change, in which case
+     * their state has been cleared and the coefficients need loading again. Real-time safe.
+     */
+    bool applyFilterTopology();
+    
+    /* "Channel Mode". Every filter is designed once, and each group of channels is then loaded with the filters placed
+     * on it and on all channels (see getChannelSelections()), so the design cost doesn't grow with the channel count.
      */
-    using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+    enum class ChannelMode
+    {
+        linked,
+        leftRight,
+        midSide,
+        frontRear
+    };
+    
+    std::atomic<float>* channelModeParameter {apvts.getRawParameterValue("Channel Mode")};
+    
+    ChannelMode getSelectedChannelMode() const noexcept { return static_cast<ChannelMode>(static_cast<int>(channelModeParameter->load())); }
+    
+    // The mode the engines are set up for; only touched on the audio thread.
+    ChannelMode activeChannelMode {ChannelMode::linked};
+    
+    // Which channels of the main bus are at the front, worked out from its layout in prepareToPlay().
+    juce::uint32 frontChannels {ChannelSelection::allChannels};
+    
+    /* Sets both engines up for the "Channel Mode". Returns true if that was a change, in which case their state has
+     * been cleared and the coefficients need loading again. Real-time safe.
+     */
+    bool applyChannelMode();
+    
+    // Splits a coefficient set into what each group of channels runs, and returns how many groups there are.
+    int getChannelSelections(const ChainCoefficients& coefficients, std::array<ChannelSelection, 3>& selections) const noexcept;
+    
+    // The engine that runs the whole chain for a sample type.
+    template <typename SampleType>
+    MultichannelBiquadCascade<SampleType>& getFilterEngine() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleFilterEngine;
+        else
+            return filterEngine;
+    }
+    
+    /* The same curve as a linear phase FIR, used instead of the filter engine when "Phase Mode" is set to linear.
+     * The coefficient pipeline feeds it from its worker thread, so this must be declared before the pipeline.
+     */
+    LinearPhaseConvolver linearPhaseConvolver;
+    
+    // How long the IIR chain rings for; updated whenever the pipeline publishes, and read by getTailLengthSeconds().
+    std::atomic<double> filterTailSeconds {0.0};
+    
+    /* Designs new coefficients on a worker thread whenever a parameter changes, and hands them to
+     * processBlock() without locking or allocating. This must be declared after the APVTS.
+     */
+    CoefficientPipeline coefficientPipeline {apvts};
+    
+    // The newest coefficients the pipeline has published; only touched on the audio thread.
+    ChainCoefficients chainCoefficients;
     
-    // Declaring two chains for stereo processing; one per channel.
-    MonoChain leftChain, rightChain;
+    // Where pullLatest() copies a set to, so one that turns out to be out of date never reaches chainCoefficients.
+    ChainCoefficients pulledCoefficients;
     
-    // An enum to store the indexes of different links in the chain for ease of use.
-    enum ChainPositions {
-        LowCut,
-        Peak,
-        HighCut
+    // Spreads each change in chainCoefficients out over a number of sub-blocks, to avoid zipper noise.
+    CoefficientRamp coefficientRamp;
+    
+    // Samples, at the engine's rate, before the ramp takes its next step; see processMinimumPhase().
+    int samplesUntilRampStep {0};
+    
+    /* Sample-accurate automation. The splitter holds the changes queued for the next block, and automatedSettings is
+     * the audio thread's own copy of the settings, which split blocks design their coefficients from. A split block
+     * ends up with coefficients for the parameters as they were when it started, so any set the pipeline designed from
+     * earlier values is dropped when it arrives; automatedGeneration is the pipeline generation that block saw.
+     */
+    AutomationSplitter automationSplitter;
+    ChainSettings automatedSettings;
+    juce::uint32 automatedGeneration {0};
+    
+    // Tells the splitter where to find every parameter it can split on. Message thread only.
+    void addAutomationTargets();
+    
+    // How long a coefficient glide takes when smoothing is on.
+    static constexpr double smoothingTimeSeconds = 0.05;
+    
+    // Cached so the audio thread doesn't have to look the parameter up by name (which builds a juce::String).
+    std::atomic<float>* smoothingParameter {apvts.getRawParameterValue("Smoothing")};
+    std::atomic<float>* phaseModeParameter {apvts.getRawParameterValue("Phase Mode")};
+    
+    // Whether processBlock() is currently running the convolver; only touched on the audio thread.
+    bool linearPhaseActive {false};
+    
+    bool isLinearPhaseSelected() const noexcept { return phaseModeParameter->load() > 0.5f; }
+    
+    /* Oversampling around the filter engine, so the bilinear transform's cramping near Nyquist is pushed well out of
+     * the audible range. There's a slot for each factor and filter type, indexed [filter type][log2(factor) - 1].
+     * Building the FIR ones means designing long filters, so only the oversampler a coefficient set actually asks for
+     * is built, in prepareToPlay() or on the coefficient pipeline's worker before the set is published. The audio
+     * thread only ever reads the slots, so switching never allocates.
+     */
+    template <typename SampleType>
+    struct OversamplerSlots
+    {
+        using Oversampler = juce::dsp::Oversampling<SampleType>;
+        
+        std::array<std::array<std::unique_ptr<Oversampler>, 3>, 2> oversamplers;
+        std::array<std::array<std::atomic<Oversampler*>, 3>, 2> readyOversamplers {};
+        
+        // The oversampler processBlock() is using, or nullptr when it isn't oversampling; only touched on the audio thread.
+        Oversampler* activeOversampler {nullptr};
     };
+    
+    // Only the set matching the processing precision is ever filled in.
+    OversamplerSlots<float> floatOversamplers;
+    OversamplerSlots<double> doubleOversamplers;
+    juce::CriticalSection oversamplerLock;
+    int oversamplerNumChannels {0};
+    
+    template <typename SampleType>
+    OversamplerSlots<SampleType>& getOversamplerSlots() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleOversamplers;
+        else
+            return floatOversamplers;
+    }
+    
+    // Builds the oversampler a coefficient set will run with, if it hasn't been already. Not real-time safe.
+    void prepareOversampler(const ChainCoefficients& coefficients);
+    
+    template <typename SampleType>
+    void prepareOversampler(OversamplerSlots<SampleType>& slots, size_t filterIndex, size_t factorIndex);
+    
+    std::atomic<float>* oversamplingParameter {apvts.getRawParameterValue("Oversampling")};
+    std::atomic<float>* oversamplingFilterParameter {apvts.getRawParameterValue("Oversampling Filter")};
+    
+    // The most samples the host promised to send at once.
+    size_t maximumBlockSize {0};
+    
+    /* Picks an oversampler by "Oversampling" and "Oversampling Filter" choice indices; nullptr when oversampling is off,
+     * or when that one hasn't been built yet. Real-time safe.
+     */
+    template <typename SampleType>
+    static typename OversamplerSlots<SampleType>::Oversampler* getOversampler(const OversamplerSlots<SampleType>& slots,
+                                                                              int oversamplingIndex, int filterIndex) noexcept;
+    
+    // The latency of the selected phase mode and oversampling settings, in samples.
+    int getLatencyForSelectedMode() const noexcept;
+    
+    // Tells the host about the latency of the selected mode. Message thread only.
+    void handleAsyncUpdate() override;
+    
+    CallbackTelemetry telemetry;
+    AnalyzerFifo analyzerFifo;
+    
+    // Reads and writes the parameters in our binary state format. This must be declared after the APVTS.
+    ParameterState parameterState {apvts};
+    PresetBank presetBank;
+    
+    /* Sets every parameter from a binary state as one change: the coefficient pipeline is held back until the last
+     * parameter is in, so the audio thread glides straight from the old settings to the new ones.
+     */
+    bool applyState(const void* data, size_t sizeInBytes);
+    
+    /* The dynamic bands' level detectors, and the coefficients each dynamic band was last given. The engine's own copy
+     * is overwritten whenever the static coefficients are loaded, so these are put back straight after.
+     */
+    DynamicBandDetector dynamicBandDetector;
+    std::array<BiquadCoefficients, maxDynamicBands> dynamicBandCoefficients;
+    bool anyDynamicBands {false};
+    
+    // How often, in host samples, the dynamic bands follow their detectors.
+    static constexpr size_t dynamicStepSize = 32;
+    
+    // Hands the dynamic settings in chainCoefficients to the detectors. Real-time safe.
+    void prepareDynamicBands();
+    
+    // Redesigns every dynamic band for the gain its detector currently asks for. Real-time safe.
+    void updateDynamicBands();
+    
+    // Everything processBlock() does, for either precision.
+    template <typename SampleType>
+    void processBlockInternal(juce::AudioBuffer<SampleType>& buffer);
+    
+    /* Runs a block in segments, one per group of queued changes, redesigning what each segment's changes touch on the
+     * way. generation is the pipeline's generation when the block started. Real-time safe.
+     */
+    template <typename SampleType>
+    void processAutomated(juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& sidechain,
+                          int subBlockSize, juce::uint32 generation);
+    
+    // Runs a block (or segment) through the IIR path, with or without the dynamic bands.
+    template <typename SampleType>
+    void processFilters(juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& sidechain, int subBlockSize);
+    
+    // Runs a block through the filter engine in short chunks, moving the dynamic bands between each one.
+    template <typename SampleType>
+    void processDynamic(juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& sidechain, int subBlockSize);
+    
+    // Runs a block through the filter engine, inside whichever oversampler matches the current coefficients.
+    template <typename SampleType>
+    void processOversampled(juce::dsp::AudioBlock<SampleType>& block, int subBlockSize);
+    
+    // Runs a block through the filter engine, stepping through any coefficient ramp in sub-blocks.
+    template <typename SampleType>
+    void processMinimumPhase(juce::dsp::AudioBlock<SampleType>& block, int subBlockSize);
+    
+    // Runs a block (or sub-block) through the filter engine, or through both engines in mixed precision.
+    template <typename SampleType>
+    void processChains(juce::dsp::AudioBlock<SampleType>& block);
+    
+    // Converts a "Smoothing" choice index into a sub-block length in samples, or 0 when smoothing is off.
+    static int getSmoothingSubBlockSize(int smoothingChoice);
+    
+    // Loads a coefficient set into the engine (or engines) in use. Real-time safe.
+    void updateFilters(const ChainCoefficients& coefficients);
+    
+    /* Redesigns the parts of chainCoefficients an automation segment changed from automatedSettings, and loads just
+     * those filters, unless one has switched on or off, changed length or moved. Real-time safe.
+     */
+    void applyAutomatedChanges(const AutomationSplitter::ChangedParts& changed);
+    
+    // Loads a dynamic band's coefficients into whichever engine is running it. Real-time safe.
+    void updateBandFilter(int band, const BiquadCoefficients& coefficients);
+    
+    // Clears the state of every engine in use, for a clean start after a switch of path. Real-time safe.
+    void resetFilters();
+    
+    // Clears the engines, the detectors, the convolver and the oversamplers: everything that holds signal. Real-time safe.
+    void resetSignalPath();
+    
+    /* Silence detection. A block is silent when every sample of the main bus is within silenceThreshold of zero, and
+     * once the input has been silent for getSilenceHoldSamples(), processBlock() stops processing until it isn't.
+     * Only touched on the audio thread.
+     */
+    static constexpr double silenceThreshold = 3.0e-8;   // about -150 dBFS, below the last bit of 24-bit audio
+    juce::int64 silentSamples {0};
+    bool sleeping {false};
+    
+    template <typename SampleType>
+    static bool isSilent(const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+    
+    // The latency plus the tail of the current path, in samples.
+    juce::int64 getSilenceHoldSamples() const noexcept;
+    
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BasicEQAudioProcessor)
 };
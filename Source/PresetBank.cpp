@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+#include "ParameterState.h"
+
+bool PresetBank::open(const juce::File& file)
+{
+    close();
+
+    auto mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    const auto* bytes = static_cast<const juce::uint8*>(mapping->getData());
+    const auto size = mapping->getSize();
+
+    if (bytes == nullptr || size < headerSize || juce::ByteOrder::littleEndianInt(bytes) != magic)
+        return false;
+
+    const auto storedHeaderSize = static_cast<size_t>(juce::ByteOrder::littleEndianShort(bytes + 6));
+    const auto count = static_cast<size_t>(juce::ByteOrder::littleEndianInt(bytes + 8));
+    const auto storedEntries = static_cast<size_t>(juce::ByteOrder::littleEndianInt(bytes + 12));
+
+    // As with the states, a newer version may grow the header or the entries, but never shrink them.
+    if (storedHeaderSize < headerSize || storedHeaderSize > size || storedEntries < entrySize
+        || count > static_cast<size_t>(std::numeric_limits<int>::max()))
+        return false;
+
+    /* The entry table has to fit in what's left after the header. count * storedEntries could overflow for a
+     * corrupt file, so the bound is checked by dividing the space instead; every i * storedEntries below is then
+     * known to be in range.
+     */
+    if (count > (size - storedHeaderSize) / storedEntries)
+        return false;
+
+    // Check every preset now, so recalling one later never has to.
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto* entry = bytes + storedHeaderSize + i * storedEntries;
+        const auto offset = static_cast<size_t>(juce::ByteOrder::littleEndianInt(entry));
+        const auto length = static_cast<size_t>(juce::ByteOrder::littleEndianInt(entry + 4));
+
+        if (offset > size || length > size - offset || ! ParameterState::isValid(bytes + offset, length))
+            return false;
+    }
+
+    mappedFile = std::move(mapping);
+    entries = bytes + storedHeaderSize;
+    storedEntrySize = storedEntries;
+    numPresets = static_cast<int>(count);
+
+    return true;
+}
+
+void PresetBank::close()
+{
+    numPresets = 0;
+    entries = nullptr;
+    mappedFile.reset();
+}
+
+const juce::uint8* PresetBank::getEntry(int index) const noexcept
+{
+    if (! juce::isPositiveAndBelow(index, numPresets))
+        return nullptr;
+
+    return entries + static_cast<size_t>(index) * storedEntrySize;
+}
+
+juce::String PresetBank::getPresetName(int index) const
+{
+    if (const auto* entry = getEntry(index))
+    {
+        const auto* name = reinterpret_cast<const char*>(entry + 8);
+        return juce::String::fromUTF8(name, static_cast<int>(std::find(name, name + maxNameLength, 0) - name));
+    }
+
+    return {};
+}
+
+PresetBank::StateView PresetBank::getPresetState(int index) const noexcept
+{
+    if (const auto* entry = getEntry(index))
+    {
+        const auto* bytes = static_cast<const juce::uint8*>(mappedFile->getData());
+
+        return { bytes + juce::ByteOrder::littleEndianInt(entry),
+                 static_cast<size_t>(juce::ByteOrder::littleEndianInt(entry + 4)) };
+    }
+
+    return {};
+}
+
+//==============================================================================
+bool PresetBank::write(const juce::File& file, const juce::StringArray& names, const juce::Array<juce::MemoryBlock>& states)
+{
+    jassert(names.size() == states.size());
+
+    juce::MemoryOutputStream stream;
+
+    stream.writeInt(static_cast<int>(magic));
+    stream.writeShort(static_cast<short>(currentVersion));
+    stream.writeShort(static_cast<short>(headerSize));
+    stream.writeInt(states.size());
+    stream.writeInt(static_cast<int>(entrySize));
+
+    // The presets follow straight on from the entry table, in the same order.
+    auto offset = headerSize + static_cast<size_t>(states.size()) * entrySize;
+
+    for (int i = 0; i < states.size(); ++i)
+    {
+        std::array<char, maxNameLength> name {};
+        names[i].copyToUTF8(name.data(), maxNameLength);
+
+        stream.writeInt(static_cast<int>(offset));
+        stream.writeInt(static_cast<int>(states.getReference(i).getSize()));
+        stream.write(name.data(), name.size());
+
+        offset += states.getReference(i).getSize();
+    }
+
+    for (const auto& state : states)
+        stream.write(state.getData(), state.getSize());
+
+    // Written to a temporary file and moved into place, so a bank that's open elsewhere never sees half a file.
+    juce::TemporaryFile temporary(file);
+
+    if (! temporary.getFile().replaceWithData(stream.getData(), stream.getDataSize()))
+        return false;
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    A file of ParameterState presets, memory-mapped for instant recall.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/* A bank is one file holding any number of presets, each stored in the ParameterState format:
+ *
+ *     header:  uint32 magic ('BEQB'), uint16 version, uint16 headerSize, uint32 numPresets, uint32 entrySize
+ *     entry:   uint32 offset, uint32 size, char name[56] (UTF-8, zero padded)
+ *     ...followed by the presets themselves.
+ *
+ * The file is memory-mapped rather than read in, and every entry is checked once when it's opened. After that,
+ * recalling a preset just hands out a pointer into the mapping, so switching between presets for A/B comparison
+ * doesn't read or parse anything. The OS pages in whatever is actually used.
+ */
+class PresetBank
+{
+public:
+    // Maps a bank file. Returns false, and leaves the bank empty, if the file isn't a valid bank.
+    bool open(const juce::File& file);
+    void close();
+
+    int getNumPresets() const noexcept { return numPresets; }
+    juce::String getPresetName(int index) const;
+
+    /* Where a preset's state lives inside the mapping; it stays valid until the bank is closed or reopened.
+     * Returns a null pointer for an index that's out of range.
+     */
+    struct StateView
+    {
+        const void* data { nullptr };
+        size_t size { 0 };
+    };
+
+    StateView getPresetState(int index) const noexcept;
+
+    // Writes a bank file from a list of names and states written by ParameterState::write().
+    static bool write(const juce::File& file, const juce::StringArray& names, const juce::Array<juce::MemoryBlock>& states);
+
+    static constexpr juce::uint32 magic = 0x42514542; // "BEQB", read as a little-endian uint32
+    static constexpr juce::uint16 currentVersion = 1;
+
+private:
+    static constexpr size_t headerSize = 16;
+    static constexpr size_t entrySize = 64;
+    static constexpr size_t maxNameLength = entrySize - 8;
+
+    const juce::uint8* getEntry(int index) const noexcept;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const juce::uint8* entries { nullptr };
+    size_t storedEntrySize { entrySize };
+    int numPresets { 0 };
+};
@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurve.h"
+
+bool ResponseCurve::update(const ChainSettings& settings, double sampleRate)
+{
+    const auto designSampleRate = sampleRate * CoefficientDesign::getOversamplingFactor(settings.oversampling);
+    const auto gridChanged = designSampleRate != gridSampleRate;
+
+    if (gridChanged)
+        prepareGrid(designSampleRate);
+
+    auto& old = cachedSettings;
+    bool anythingChanged = gridChanged;
+
+    if (gridChanged || settings.lowCutFrequency != old.lowCutFrequency || settings.lowCutSlope != old.lowCutSlope)
+    {
+        std::array<BiquadCoefficients, maxCutSections> sections;
+        const auto numSections = CoefficientDesign::getNumCutSections(settings.lowCutSlope);
+        CoefficientDesign::makeLowCut(designSampleRate, settings.lowCutFrequency, numSections, sections.data());
+        computeGroup(lowCutGroup, sections.data(), numSections);
+
+        old.lowCutFrequency = settings.lowCutFrequency;
+        old.lowCutSlope = settings.lowCutSlope;
+        anythingChanged = true;
+    }
+
+    if (gridChanged || settings.highCutFrequency != old.highCutFrequency || settings.highCutSlope != old.highCutSlope)
+    {
+        std::array<BiquadCoefficients, maxCutSections> sections;
+        const auto numSections = CoefficientDesign::getNumCutSections(settings.highCutSlope);
+        CoefficientDesign::makeHighCut(designSampleRate, settings.highCutFrequency, numSections, sections.data());
+        computeGroup(highCutGroup, sections.data(), numSections);
+
+        old.highCutFrequency = settings.highCutFrequency;
+        old.highCutSlope = settings.highCutSlope;
+        anythingChanged = true;
+    }
+
+    // Only the bands that moved are designed and evaluated again; the others keep their cached curves.
+    for (size_t i = 0; i < static_cast<size_t>(maxBands); ++i)
+    {
+        auto band = settings.bands[i];
+
+        if (static_cast<int>(i) >= settings.numBands)
+            band.type = BandType::off;
+
+        auto& cached = old.bands[i];
+
+        if (! gridChanged && band.type == cached.type && band.frequency == cached.frequency
+            && band.gainDecibels == cached.gainDecibels && band.quality == cached.quality)
+            continue;
+
+        const auto section = CoefficientDesign::makeBand(designSampleRate, band);
+        const auto isPassThrough = CoefficientDesign::isPassThrough(section);
+        computeGroup(firstBandGroup + static_cast<int>(i), &section, isPassThrough ? 0 : 1);
+
+        cached = band;
+        anythingChanged = true;
+    }
+
+    if (! anythingChanged)
+        return false;
+
+    // Cascaded gains add up in decibels.
+    juce::FloatVectorOperations::add(decibels.data(), groupDecibels[lowCutGroup].data(), groupDecibels[highCutGroup].data(), numPoints);
+
+    for (int group = firstBandGroup; group < numGroups; ++group)
+        if (! isFlat[static_cast<size_t>(group)])
+            juce::FloatVectorOperations::add(decibels.data(), groupDecibels[static_cast<size_t>(group)].data(), numPoints);
+
+    return true;
+}
+
+void ResponseCurve::prepareGrid(double designSampleRate)
+{
+    gridSampleRate = designSampleRate;
+
+    for (auto* terms : { &cosOmega, &cos2Omega, &sinOmega, &sin2Omega, &numerator, &denominator })
+        terms->resize(numVectors);
+
+    for (size_t v = 0; v < numVectors; ++v)
+    {
+        for (size_t lane = 0; lane < Vec::SIMDNumElements; ++lane)
+        {
+            const auto index = static_cast<double>(v * Vec::SIMDNumElements + lane);
+            const auto frequency = minFrequency * std::pow(static_cast<double>(maxFrequency / minFrequency), index / (numPoints - 1));
+
+            // Anything above Nyquist is clamped to it; that only happens when the host runs below 40 kHz.
+            const auto omega = juce::MathConstants<double>::twoPi * juce::jmin(frequency, designSampleRate / 2.0) / designSampleRate;
+
+            cosOmega[v].set(lane, std::cos(omega));
+            cos2Omega[v].set(lane, std::cos(2.0 * omega));
+            sinOmega[v].set(lane, std::sin(omega));
+            sin2Omega[v].set(lane, std::sin(2.0 * omega));
+        }
+    }
+}
+
+void ResponseCurve::computeGroup(int group, const BiquadCoefficients* sections, int numSections)
+{
+    // A band that's off or flat is 0 dB everywhere, and can be left out of the sum altogether.
+    isFlat[static_cast<size_t>(group)] = numSections == 0;
+
+    if (numSections == 0)
+    {
+        groupDecibels[static_cast<size_t>(group)].fill(0.f);
+        return;
+    }
+
+    /* For each section, |b0 + b1 z^-1 + b2 z^-2|^2 and |1 + a1 z^-1 + a2 z^-2|^2, with z^-n = cos(n w) - j sin(n w).
+     * The sign of the imaginary part doesn't matter once it's squared. SIMDRegister has no division, so the numerators
+     * and denominators are multiplied up separately and only divided once, per point, at the end.
+     */
+    for (size_t v = 0; v < numVectors; ++v)
+    {
+        auto num = Vec::expand(1.0);
+        auto den = Vec::expand(1.0);
+
+        for (int s = 0; s < numSections; ++s)
+        {
+            const auto& c = sections[s];
+
+            const auto numReal = cosOmega[v] * c.b1 + cos2Omega[v] * c.b2 + c.b0;
+            const auto numImag = sinOmega[v] * c.b1 + sin2Omega[v] * c.b2;
+            const auto denReal = cosOmega[v] * c.a1 + cos2Omega[v] * c.a2 + 1.0;
+            const auto denImag = sinOmega[v] * c.a1 + sin2Omega[v] * c.a2;
+
+            num *= numReal * numReal + numImag * numImag;
+            den *= denReal * denReal + denImag * denImag;
+        }
+
+        numerator[v] = num;
+        denominator[v] = den;
+    }
+
+    // Power ratio to decibels. The floor is far below anything the display shows, and keeps a zero out of the log.
+    auto& destination = groupDecibels[static_cast<size_t>(group)];
+
+    for (size_t i = 0; i < static_cast<size_t>(numPoints); ++i)
+    {
+        const auto v = i / Vec::SIMDNumElements;
+        const auto lane = i % Vec::SIMDNumElements;
+        const auto power = numerator[v].get(lane) / juce::jmax(denominator[v].get(lane), 1.0e-300);
+
+        destination[i] = static_cast<float>(10.0 * std::log10(juce::jmax(power, 1.0e-30)));
+    }
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.h
+
+    Computes the EQ's magnitude response for display, caching as much of
+    the work as possible.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterDesign.h"
+#include "PluginProcessor.h"
+
+/* The response is evaluated on a fixed grid of log-spaced frequencies rather than per pixel, so its cost doesn't
+ * depend on the size of the editor. The z^-1 and z^-2 terms at every grid point only depend on the sample rate,
+ * so they're worked out once and kept.
+ *
+ * The chain is split into groups: the low cut sections, the high cut sections, and each band on its own. Each group's
+ * response is cached in decibels, and when the settings change only the groups whose settings actually moved are
+ * recomputed. Dragging one band around never touches the others, or the cut filters, which are the expensive part
+ * at steep slopes.
+ *
+ * Within a group, the squared magnitudes of the numerator and denominator of every section are multiplied together
+ * across several grid points at once with juce::dsp::SIMDRegister, and only the final division and log are scalar.
+ * They're kept in double precision, because a steep cut's stopband underflows a float well before it's off the chart.
+ */
+class ResponseCurve
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<double>;
+
+    static constexpr float minFrequency = 20.f;
+    static constexpr float maxFrequency = 20000.f;
+
+    // Enough points for a smooth curve across a 4K display.
+    static constexpr int numPoints = 1024;
+
+    /* Brings the curve up to date with a settings snapshot and the host sample rate.
+     * Returns true if anything changed, in which case getDecibels() has the new curve.
+     */
+    bool update(const ChainSettings& settings, double sampleRate);
+
+    // The gain of the whole chain at each grid point, from minFrequency to maxFrequency.
+    const std::array<float, numPoints>& getDecibels() const noexcept { return decibels; }
+
+private:
+    // The cuts come first, then one group per band.
+    enum Group
+    {
+        lowCutGroup,
+        highCutGroup,
+        firstBandGroup,
+        numGroups = firstBandGroup + maxBands
+    };
+
+    // Precomputes the z^-1 and z^-2 terms at every grid point for a design rate.
+    void prepareGrid(double designSampleRate);
+
+    // Recomputes one group's cached response from its sections.
+    void computeGroup(int group, const BiquadCoefficients* sections, int numSections);
+
+    static_assert(numPoints % Vec::SIMDNumElements == 0, "The grid must fill a whole number of registers");
+    static constexpr size_t numVectors = static_cast<size_t>(numPoints) / Vec::SIMDNumElements;
+
+    // The real and imaginary parts of z^-1 and z^-2 at every grid point; the imaginary parts are negated.
+    std::vector<Vec> cosOmega, cos2Omega, sinOmega, sin2Omega;
+
+    // Scratch for the numerator and denominator products of a group.
+    std::vector<Vec> numerator, denominator;
+
+    std::array<std::array<float, numPoints>, numGroups> groupDecibels {};
+    std::array<bool, numGroups> isFlat {};
+    std::array<float, numPoints> decibels {};
+
+    double gridSampleRate { 0.0 };
+    // The settings each group was last computed from. Bands past the band count are cached as off.
+    ChainSettings cachedSettings;
+};
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    ResponseCurveComponent.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurveComponent.h"
+#include "SpectrumAnalyzer.h"
+
+ResponseCurveComponent::ResponseCurveComponent(BasicEQAudioProcessor& p)
+    : audioProcessor(p)
+{
+    // The analyzer underneath handles the background and any mouse input.
+    setInterceptsMouseClicks(false, false);
+
+    static_assert(ResponseCurve::minFrequency == SpectrumAnalyzer::minFrequency
+                  && ResponseCurve::maxFrequency == SpectrumAnalyzer::maxFrequency,
+                  "The curve has to line up with the analyzer's frequency axis");
+
+    startTimerHz(frameRateHz);
+}
+
+//==============================================================================
+void ResponseCurveComponent::timerCallback()
+{
+    // Before the host has prepared us there's no sample rate yet, so show the curve as it would be at 44.1 kHz.
+    const auto sampleRate = audioProcessor.getSampleRate() > 0.0 ? audioProcessor.getSampleRate() : 44100.0;
+
+    if (curve.update(getChainSettings(audioProcessor.apvts), sampleRate))
+        rebuildPath();
+}
+
+void ResponseCurveComponent::resized()
+{
+    curveBounds = getLocalBounds();
+    rebuildPath();
+}
+
+void ResponseCurveComponent::rebuildPath()
+{
+    const auto bounds = getLocalBounds().toFloat();
+    const auto& decibels = curve.getDecibels();
+    juce::Path path;
+
+    for (int i = 0; i < ResponseCurve::numPoints; ++i)
+    {
+        // The grid is log-spaced over the same range as the analyzer, so the points are evenly spread across it.
+        const auto x = bounds.getX() + bounds.getWidth() * static_cast<float>(i) / (ResponseCurve::numPoints - 1);
+
+        // Clamp a little beyond the edges, so a steep cut runs off the bottom rather than stopping at it.
+        const auto level = juce::jlimit(minDecibels - 1.f, maxDecibels + 1.f, decibels[static_cast<size_t>(i)]);
+        const auto y = juce::jmap(level, minDecibels, maxDecibels, bounds.getBottom(), bounds.getY());
+
+        if (i == 0)
+            path.startNewSubPath(x, y);
+        else
+            path.lineTo(x, y);
+    }
+
+    const auto newBounds = path.getBounds().getSmallestIntegerContainer().expanded(2);
+    repaint(curveBounds.getUnion(newBounds));
+
+    curvePath = std::move(path);
+    curveBounds = newBounds;
+}
+
+void ResponseCurveComponent::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::white);
+    g.strokePath(curvePath, juce::PathStrokeType(2.f));
+}
@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    ResponseCurveComponent.h
+
+    Draws the EQ's frequency response over the spectrum analyzer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "ResponseCurve.h"
+
+/* A transparent overlay that sits exactly on top of the SpectrumAnalyzer and shares its frequency axis.
+ *
+ * It polls the parameters at the display's frame rate rather than listening to them, so a burst of automation or a
+ * fast drag costs one update per frame, however many parameter changes it's made of. The ResponseCurve works out
+ * which parts of the chain actually changed, and the path is only rebuilt, and its strip only repainted, when the
+ * curve has moved.
+ */
+class ResponseCurveComponent  : public juce::Component,
+                                private juce::Timer
+{
+public:
+    explicit ResponseCurveComponent(BasicEQAudioProcessor& processor);
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    // The curve's vertical range. It's much narrower than the analyzer's, so small boosts and cuts are easy to see.
+    static constexpr float minDecibels = -24.f;
+    static constexpr float maxDecibels = 24.f;
+
+private:
+    void timerCallback() override;
+
+    // Turns the curve into a path for the current size, and repaints wherever the old and new paths are.
+    void rebuildPath();
+
+    static constexpr int frameRateHz = 60;
+
+    BasicEQAudioProcessor& audioProcessor;
+
+    ResponseCurve curve;
+    juce::Path curvePath;
+    juce::Rectangle<int> curveBounds;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponseCurveComponent)
+};
@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    SharedResources.cpp
+
+  ==============================================================================
+*/
+
+#include "SharedResources.h"
+
+// Runs a Worker's doWork() on the pool, then drops out of the pool until the scheduler finds more work.
+class SharedResources::WorkerJob  : public juce::ThreadPoolJob
+{
+public:
+    explicit WorkerJob(Worker& w) : juce::ThreadPoolJob("BasicEQ Work"), worker(w) {}
+
+    JobStatus runJob() override
+    {
+        worker.doWork();
+        return jobHasFinished;
+    }
+
+    Worker& worker;
+};
+
+class SharedResources::Scheduler  : public juce::Thread
+{
+public:
+    explicit Scheduler(SharedResources& r) : juce::Thread("BasicEQ Scheduler"), resources(r) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            resources.pollWorkers();
+            wait(pollIntervalMs);
+        }
+    }
+
+private:
+    SharedResources& resources;
+};
+
+//==============================================================================
+SharedResources::SharedResources()
+    // A couple of threads is plenty: the work is short bursts, and most instances are idle at any moment.
+    : pool(juce::jlimit(1, 4, juce::SystemStats::getNumCpus() / 4))
+{
+    scheduler = std::make_unique<Scheduler>(*this);
+    scheduler->startThread(juce::Thread::Priority::low);
+}
+
+SharedResources::~SharedResources()
+{
+    // Every instance should have removed its Workers before letting go of the registry.
+    jassert(jobs.empty());
+
+    scheduler->stopThread(1000);
+    pool.removeAllJobs(true, 1000);
+}
+
+const juce::dsp::FFT& SharedResources::getFFT(int order)
+{
+    const juce::ScopedLock sl(cacheLock);
+    auto& fft = ffts[order];
+
+    if (fft == nullptr)
+        fft = std::make_unique<juce::dsp::FFT>(order);
+
+    return *fft;
+}
+
+const std::vector<float>& SharedResources::getHannWindow(int size)
+{
+    const juce::ScopedLock sl(cacheLock);
+    auto& window = hannWindows[size];
+
+    if (window.empty())
+    {
+        window.resize(static_cast<size_t>(size));
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(),
+                                                                 juce::dsp::WindowingFunction<float>::hann, true);
+    }
+
+    return window;
+}
+
+void SharedResources::addWorker(Worker& worker)
+{
+    const juce::ScopedLock sl(workersLock);
+
+    for (auto& job : jobs)
+        if (&job->worker == &worker)
+            return;
+
+    jobs.push_back(std::make_unique<WorkerJob>(worker));
+}
+
+void SharedResources::removeWorker(Worker& worker)
+{
+    std::unique_ptr<WorkerJob> removed;
+
+    {
+        const juce::ScopedLock sl(workersLock);
+        const auto found = std::find_if(jobs.begin(), jobs.end(), [&worker](const auto& job) { return &job->worker == &worker; });
+
+        if (found == jobs.end())
+            return;
+
+        removed = std::move(*found);
+        jobs.erase(found);
+    }
+
+    // The scheduler can't queue it again now, so once it's out of the pool it's gone for good.
+    pool.removeJob(removed.get(), false, -1);
+}
+
+void SharedResources::pollWorkers()
+{
+    const juce::ScopedLock sl(workersLock);
+
+    // A job that's still queued or running will pick up any new work when it gets to it, or on the next poll.
+    for (auto& job : jobs)
+        if (! pool.contains(job.get()) && job->worker.hasWork())
+            pool.addJob(job.get(), false);
+}
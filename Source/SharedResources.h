@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    SharedResources.h
+
+    Everything that every instance of the plugin in a process can share:
+    FFT plans, analysis windows and a small pool of worker threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DesignTables.h"
+
+#include <map>
+
+/* A large session can have a hundred or more instances loaded. On their own, each would build its own FFT plans and
+ * windows, and start its own background threads to design coefficients and linear phase kernels, even though
+ * almost all of them sit idle almost all of the time.
+ *
+ * Instead, every instance holds a juce::SharedResourcePointer<SharedResources>. The first one to be created builds
+ * the registry and the last one to go takes it with it, so the registry lives exactly as long as there's an instance
+ * around to use it.
+ *
+ * Plans and windows are immutable once they're built, and are kept by size (which is what the sample rate and block
+ * size decide), so instances running at the same settings share a single copy. The filter designers' DesignTables
+ * are already shared process-wide; getDesignTables() just makes them reachable from here like everything else.
+ *
+ * Background work goes through Workers. One shared thread polls every registered Worker every pollIntervalMs, and
+ * any that have something to do get it run on a small shared thread pool. However many instances are loaded, the
+ * process only ever has that one polling thread and the pool's few threads working on their behalf.
+ */
+class SharedResources
+{
+public:
+    SharedResources();
+    ~SharedResources();
+
+    const DesignTables& getDesignTables() const noexcept   { return DesignTables::getInstance(); }
+
+    /* An FFT plan, built the first time any instance asks for this order. Not real-time safe.
+     * JUCE's fallback engine serialises calls on a plan with a spin lock, so these are meant for background threads
+     * (designing kernels, analysing spectra) where that doesn't matter; anything on the audio thread needs its own.
+     */
+    const juce::dsp::FFT& getFFT(int order);
+
+    // A normalised Hann window of the given size, built the first time any instance asks for it. Not real-time safe.
+    const std::vector<float>& getHannWindow(int size);
+
+    /* Something that needs work done in the background now and then. hasWork() is called on the polling thread and
+     * should only check a flag or two; doWork() is called on one of the pool's threads, and never on two at once.
+     */
+    class Worker
+    {
+    public:
+        virtual ~Worker() = default;
+
+        virtual bool hasWork() = 0;
+        virtual void doWork() = 0;
+    };
+
+    // Starts polling a Worker. Not real-time safe.
+    void addWorker(Worker& worker);
+
+    // Stops polling a Worker, and waits for any work of its that's queued or running to finish. Not real-time safe.
+    void removeWorker(Worker& worker);
+
+    // How often Workers are asked whether they have anything to do.
+    static constexpr int pollIntervalMs = 5;
+
+private:
+    class WorkerJob;
+    class Scheduler;
+
+    void pollWorkers();
+
+    juce::CriticalSection cacheLock;
+    std::map<int, std::unique_ptr<juce::dsp::FFT>> ffts;
+    std::map<int, std::vector<float>> hannWindows;
+
+    // Declared before the scheduler, so the scheduler has stopped before the jobs and the pool go.
+    juce::ThreadPool pool;
+    juce::CriticalSection workersLock;
+    std::vector<std::unique_ptr<WorkerJob>> jobs;
+
+    std::unique_ptr<Scheduler> scheduler;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedResources)
+};
@@ -0,0 +1,243 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+SpectrumAnalyzer::SpectrumAnalyzer(AnalyzerFifo& source)
+    : juce::Thread("BasicEQ Analyzer"), fifo(source)
+{
+    // We paint every pixel ourselves, so nothing behind us ever needs repainting along with us.
+    setOpaque(true);
+
+    levels.fill(minDecibels);
+    publishedLevels.fill(minDecibels);
+    displayedLevels.fill(minDecibels);
+
+    fifo.setActive(true);
+    startThread(juce::Thread::Priority::low);
+    startTimerHz(frameRateHz);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stopTimer();
+    stopThread(1000);
+    fifo.setActive(false);
+}
+
+float SpectrumAnalyzer::getProportionForFrequency(float frequency) noexcept
+{
+    return std::log(frequency / minFrequency) / std::log(maxFrequency / minFrequency);
+}
+
+//==============================================================================
+void SpectrumAnalyzer::run()
+{
+    // Anything left over from the last time an analyzer was open is stale, so throw it away first.
+    std::array<float, hopSize> incoming;
+
+    while (fifo.pull(incoming.data(), hopSize) > 0)
+        ;
+
+    while (! threadShouldExit())
+    {
+        const auto numRead = fifo.pull(incoming.data(), hopSize - samplesSinceLastFrame);
+
+        if (numRead == 0)
+        {
+            wait(10);
+            continue;
+        }
+
+        // Slide the history along and append the new samples.
+        std::copy(history.begin() + numRead, history.end(), history.begin());
+        std::copy(incoming.begin(), incoming.begin() + numRead, history.end() - numRead);
+
+        samplesSinceLastFrame += numRead;
+
+        if (samplesSinceLastFrame >= hopSize)
+        {
+            samplesSinceLastFrame = 0;
+            analyseFrame();
+        }
+    }
+}
+
+void SpectrumAnalyzer::updatePointBins(double sampleRate)
+{
+    analysedSampleRate = sampleRate;
+
+    const auto binsPerHertz = fftSize / sampleRate;
+    const auto maxBin = fftSize / 2 - 1;
+
+    auto getFrequency = [](double index)
+    {
+        return minFrequency * std::pow(maxFrequency / minFrequency, index / (numPoints - 1));
+    };
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        /* Low down, points are closer together than bins, so each point interpolates between its two nearest bins.
+         * Higher up, a point covers many bins, and takes the loudest of them so narrow peaks don't go missing.
+         */
+        const auto bin = juce::jlimit(0.0, static_cast<double>(maxBin), getFrequency(i) * binsPerHertz);
+        const auto lowestBin = juce::jlimit(0, maxBin, static_cast<int>(std::ceil(getFrequency(i - 0.5) * binsPerHertz)));
+        const auto highestBin = juce::jlimit(0, maxBin, static_cast<int>(std::floor(getFrequency(i + 0.5) * binsPerHertz)));
+
+        if (highestBin > lowestBin)
+        {
+            pointBins[static_cast<size_t>(i)] = { lowestBin, highestBin };
+        }
+        else
+        {
+            pointBins[static_cast<size_t>(i)] = { static_cast<int>(bin), static_cast<int>(bin) };
+            pointFractions[static_cast<size_t>(i)] = static_cast<float>(bin - std::floor(bin));
+        }
+    }
+}
+
+void SpectrumAnalyzer::analyseFrame()
+{
+    const auto sampleRate = fifo.getSampleRate();
+
+    if (sampleRate != analysedSampleRate)
+        updatePointBins(sampleRate);
+
+    std::copy(history.begin(), history.end(), fftData.begin());
+    juce::FloatVectorOperations::multiply(fftData.data(), window.data(), fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    // The window is normalised, so a full scale sine comes out at fftSize / 2; that's our 0 dB.
+    const auto scale = 2.f / static_cast<float>(fftSize);
+    const auto release = releaseDecibelsPerSecond * static_cast<float>(hopSize / sampleRate);
+
+    for (size_t i = 0; i < static_cast<size_t>(numPoints); ++i)
+    {
+        const auto [first, last] = pointBins[i];
+        float magnitude = 0.f;
+
+        if (last > first)
+        {
+            magnitude = *std::max_element(fftData.begin() + first, fftData.begin() + last + 1);
+        }
+        else
+        {
+            const auto fraction = pointFractions[i];
+            magnitude = fftData[static_cast<size_t>(first)] * (1.f - fraction) + fftData[static_cast<size_t>(first + 1)] * fraction;
+        }
+
+        // Rise instantly, but fall back at a steady rate.
+        const auto decibels = juce::Decibels::gainToDecibels(magnitude * scale, minDecibels);
+        levels[i] = juce::jmax(decibels, levels[i] - release);
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType sl(levelsLock);
+        publishedLevels = levels;
+    }
+
+    hasNewLevels = true;
+}
+
+//==============================================================================
+void SpectrumAnalyzer::timerCallback()
+{
+    if (! hasNewLevels.exchange(false))
+        return;
+
+    {
+        const juce::SpinLock::ScopedLockType sl(levelsLock);
+
+        // Once the signal has died away and every point has settled on the floor, there's nothing left to redraw.
+        if (publishedLevels == displayedLevels)
+            return;
+
+        displayedLevels = publishedLevels;
+    }
+
+    const auto bounds = getLocalBounds().toFloat();
+    juce::Path path;
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const auto x = bounds.getX() + bounds.getWidth() * static_cast<float>(i) / (numPoints - 1);
+        const auto y = juce::jmap(displayedLevels[static_cast<size_t>(i)], minDecibels, maxDecibels, bounds.getBottom(), bounds.getY());
+
+        if (i == 0)
+            path.startNewSubPath(x, y);
+        else
+            path.lineTo(x, y);
+    }
+
+    // Only the strip that both the old and the new curve pass through needs redrawing.
+    const auto newBounds = path.getBounds().getSmallestIntegerContainer().expanded(2);
+    repaint(spectrumBounds.getUnion(newBounds));
+
+    spectrumPath = std::move(path);
+    spectrumBounds = newBounds;
+}
+
+void SpectrumAnalyzer::resized()
+{
+    drawBackground();
+
+    // Rebuild the path for the new size on the next tick, even if the analysis has stopped.
+    displayedLevels.fill(std::numeric_limits<float>::lowest());
+    hasNewLevels = true;
+    spectrumPath.clear();
+    spectrumBounds = getLocalBounds();
+}
+
+void SpectrumAnalyzer::drawBackground()
+{
+    if (getWidth() <= 0 || getHeight() <= 0)
+        return;
+
+    background = juce::Image(juce::Image::RGB, getWidth(), getHeight(), true);
+    juce::Graphics g(background);
+
+    g.fillAll(juce::Colours::black);
+
+    const auto width = static_cast<float>(getWidth());
+    const auto height = static_cast<float>(getHeight());
+
+    // Vertical lines at the usual decade points, labelled along the bottom.
+    g.setFont(10.f);
+
+    for (auto frequency : { 20.f, 50.f, 100.f, 200.f, 500.f, 1000.f, 2000.f, 5000.f, 10000.f, 20000.f })
+    {
+        const auto x = width * getProportionForFrequency(frequency);
+
+        g.setColour(juce::Colours::dimgrey);
+        g.drawVerticalLine(juce::roundToInt(x), 0.f, height);
+
+        g.setColour(juce::Colours::lightgrey);
+        g.drawText(frequency >= 1000.f ? juce::String(juce::roundToInt(frequency / 1000.f)) + "k" : juce::String(juce::roundToInt(frequency)),
+                   juce::roundToInt(x) + 2, getHeight() - 14, 40, 12, juce::Justification::left);
+    }
+
+    // Horizontal lines every 12 dB.
+    for (auto decibels = maxDecibels - 6.f; decibels > minDecibels; decibels -= 12.f)
+    {
+        const auto y = juce::jmap(decibels, minDecibels, maxDecibels, height, 0.f);
+
+        g.setColour(juce::Colours::dimgrey);
+        g.drawHorizontalLine(juce::roundToInt(y), 0.f, width);
+
+        g.setColour(juce::Colours::lightgrey);
+        g.drawText(juce::String(juce::roundToInt(decibels)) + " dB", 2, juce::roundToInt(y) + 1, 50, 12, juce::Justification::left);
+    }
+}
+
+void SpectrumAnalyzer::paint(juce::Graphics& g)
+{
+    g.drawImageAt(background, 0, 0);
+
+    g.setColour(juce::Colours::skyblue.withAlpha(0.8f));
+    g.strokePath(spectrumPath, juce::PathStrokeType(1.5f));
+}
@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+
+    Shows the spectrum of the processed signal behind the EQ controls.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalyzerFifo.h"
+#include "SharedResources.h"
+
+/* The audio thread's only job is to feed the AnalyzerFifo. Everything else happens on this component's own low
+ * priority thread: it gathers overlapping Hann-windowed frames, runs them through juce::dsp::FFT, and boils each
+ * spectrum down to a fixed number of log-spaced points, with a peak-hold style release so the display doesn't flicker.
+ *
+ * The message thread picks the newest points up at no more than frameRateHz. It only rebuilds the path and asks for
+ * a repaint when they've actually changed, and then only for the strip the old and new curves cover. The grid behind
+ * the curve is drawn once per resize into a cached image, so a repaint is an image blit and a single path stroke.
+ */
+class SpectrumAnalyzer  : public juce::Component,
+                          private juce::Thread,
+                          private juce::Timer
+{
+public:
+    explicit SpectrumAnalyzer(AnalyzerFifo& fifo);
+    ~SpectrumAnalyzer() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    // The range the display covers.
+    static constexpr float minFrequency = 20.f;
+    static constexpr float maxFrequency = 20000.f;
+    static constexpr float minDecibels = -90.f;
+    static constexpr float maxDecibels = 6.f;
+
+    // Where a frequency sits across the display, from 0 at minFrequency to 1 at maxFrequency.
+    static float getProportionForFrequency(float frequency) noexcept;
+
+private:
+    void run() override;
+    void timerCallback() override;
+
+    // Analysis thread. Windows and transforms the newest fftSize samples, and folds them into the smoothed levels.
+    void analyseFrame();
+
+    // Analysis thread. Works out which FFT bins feed each display point for a sample rate.
+    void updatePointBins(double sampleRate);
+
+    void drawBackground();
+
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+
+    // Frames overlap by 75%.
+    static constexpr int hopSize = fftSize / 4;
+
+    // The spectrum is reduced to this many log-spaced points, which is plenty for any display width.
+    static constexpr int numPoints = 256;
+
+    static constexpr int frameRateHz = 30;
+    static constexpr float releaseDecibelsPerSecond = 36.f;
+
+    AnalyzerFifo& fifo;
+
+    // The FFT plan and window are shared with every other open analyzer.
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+    const juce::dsp::FFT& fft { sharedResources->getFFT(fftOrder) };
+    const std::vector<float>& window { sharedResources->getHannWindow(fftSize) };
+
+    // Analysis thread only.
+    std::array<float, fftSize> history {};
+    std::array<float, fftSize * 2> fftData {};
+    std::array<float, numPoints> levels {};
+    std::array<std::pair<int, int>, numPoints> pointBins {};
+    std::array<float, numPoints> pointFractions {};
+    double analysedSampleRate { 0.0 };
+    int samplesSinceLastFrame { 0 };
+
+    // Handed from the analysis thread to the message thread.
+    juce::SpinLock levelsLock;
+    std::array<float, numPoints> publishedLevels {};
+    std::atomic<bool> hasNewLevels { false };
+
+    // Message thread only.
+    std::array<float, numPoints> displayedLevels {};
+    juce::Path spectrumPath;
+    juce::Rectangle<int> spectrumBounds;
+    juce::Image background;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyzer)
+};
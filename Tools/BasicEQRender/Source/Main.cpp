@@ -0,0 +1,425 @@
+/*
+  ==============================================================================
+
+    BasicEQRender - renders audio files through the BasicEQ processor without a plugin host.
+
+    Usage:
+        BasicEQRender --preset <preset.json|preset.xml> --output <directory>
+                      [--jobs <n>] [--block-size <n>] [--format <wav|aiff|flac>]
+                      <file or directory>...
+
+    A preset maps parameter IDs onto real-world values, for example
+        { "Band 1 Freq": 2500, "Band 1 Gain": -3.5, "LowCut Slope": "24 dB/Oct" }
+    or, as XML,
+        <Preset><Parameter id="Band 1 Freq" value="2500"/></Preset>
+
+    Files found in a directory are written under --output at the same path relative to that directory.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+#include <iostream>
+#include <map>
+
+//==============================================================================
+// One parameter assignment from a preset file; the value is either a number or a choice's text.
+struct PresetValue
+{
+    juce::String parameterID;
+    juce::var value;
+};
+
+static juce::Array<PresetValue> loadPreset(const juce::File& file, juce::String& error)
+{
+    juce::Array<PresetValue> values;
+
+    if (file.hasFileExtension("xml"))
+    {
+        auto xml = juce::parseXML(file);
+
+        if (xml == nullptr)
+        {
+            error = "Couldn't parse " + file.getFullPathName();
+            return {};
+        }
+
+        for (auto* parameter : xml->getChildWithTagNameIterator("Parameter"))
+            values.add({ parameter->getStringAttribute("id"), parameter->getStringAttribute("value") });
+
+        return values;
+    }
+
+    const auto json = juce::JSON::parse(file);
+
+    if (auto* object = json.getDynamicObject())
+    {
+        for (auto& property : object->getProperties())
+            values.add({ property.name.toString(), property.value });
+
+        return values;
+    }
+
+    error = "Couldn't parse " + file.getFullPathName() + " as a JSON object";
+    return {};
+}
+
+// Sets the processor's parameters from a preset. Values are given in the same units the parameters display.
+static bool applyPreset(BasicEQAudioProcessor& processor, const juce::Array<PresetValue>& preset, juce::String& error)
+{
+    for (const auto& item : preset)
+    {
+        auto* parameter = processor.apvts.getParameter(item.parameterID);
+
+        if (parameter == nullptr)
+        {
+            error = "Unknown parameter \"" + item.parameterID + "\"";
+            return false;
+        }
+
+        // Numbers are real-world values (or choice indices); text is matched against the parameter's own text.
+        const auto text = item.value.toString();
+        const auto isNumber = item.value.isDouble() || item.value.isInt() || text.containsOnly("0123456789.-+eE");
+
+        const auto number = item.value.isString() ? text.getFloatValue() : static_cast<float>(item.value);
+
+        parameter->setValueNotifyingHost(isNumber ? parameter->convertTo0to1(number) : parameter->getValueForText(text));
+    }
+
+    return true;
+}
+
+//==============================================================================
+struct RenderSettings
+{
+    juce::Array<PresetValue> preset;
+    juce::File outputDirectory;
+    juce::String outputFormat;   // Empty means the same format as the input.
+    int blockSize { 4096 };
+};
+
+/* One file to render, and where to write it. Files found in a directory keep their path relative to that
+ * directory under --output, so files with the same name in different folders don't overwrite each other.
+ */
+struct RenderJob
+{
+    juce::File input;
+    juce::File output;
+};
+
+// What a worker has done; summed up at the end.
+struct RenderStatistics
+{
+    int filesRendered { 0 };
+    int filesFailed { 0 };
+    double audioSeconds { 0.0 };
+};
+
+/* Renders files one after another with its own processor instance. Every worker pulls the next file
+ * index from a shared counter, so a slow file never holds up the rest of the batch.
+ *
+ * Memory use is bounded: each file is read, processed and written one block at a time, so a worker only
+ * ever holds a single block of audio, however long the file is.
+ */
+class RenderWorker  : public juce::Thread
+{
+public:
+    RenderWorker(int index, const RenderSettings& s, const juce::Array<RenderJob>& j, std::atomic<int>& next)
+        : juce::Thread("BasicEQ Render " + juce::String(index)), settings(s), jobs(j), nextFile(next)
+    {
+        formatManager.registerBasicFormats();
+
+        // The processor is created here, on the message thread, since the APVTS starts a timer.
+        processor = std::make_unique<BasicEQAudioProcessor>();
+        processor->setNonRealtime(true);
+    }
+
+    ~RenderWorker() override
+    {
+        stopThread(-1);
+    }
+
+    void run() override
+    {
+        for (auto index = nextFile++; index < jobs.size() && ! threadShouldExit(); index = nextFile++)
+        {
+            juce::String error;
+
+            if (renderFile(jobs.getReference(index), error))
+                ++statistics.filesRendered;
+            else
+            {
+                ++statistics.filesFailed;
+                std::cerr << jobs.getReference(index).input.getFullPathName() << ": " << error << std::endl;
+            }
+        }
+    }
+
+    const RenderStatistics& getStatistics() const noexcept { return statistics; }
+
+private:
+    bool renderFile(const RenderJob& job, juce::String& error)
+    {
+        const auto& input = job.input;
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(input));
+
+        if (reader == nullptr)
+        {
+            error = "Not a readable audio file";
+            return false;
+        }
+
+        const auto numChannels = static_cast<int>(reader->numChannels);
+        const auto sampleRate = reader->sampleRate;
+
+        if (numChannels < 1 || numChannels > MultichannelBiquadCascade<float>::maxChannels)
+        {
+            error = "Unsupported channel count " + juce::String(numChannels);
+            return false;
+        }
+
+        // The preset has to be in place before prepareToPlay(), which designs the first coefficients synchronously.
+        if (! applyPreset(*processor, settings.preset, error))
+            return false;
+
+        const auto& output = job.output;
+        const auto extension = output.getFileExtension();
+        auto* format = formatManager.findFormatForFileExtension(extension);
+
+        if (format == nullptr)
+        {
+            error = "No writer for " + extension + " files";
+            return false;
+        }
+
+        output.getParentDirectory().createDirectory();
+        output.deleteFile();
+
+        auto stream = output.createOutputStream();
+
+        if (stream == nullptr)
+        {
+            error = "Couldn't create " + output.getFullPathName();
+            return false;
+        }
+
+        // Keep the input's bit depth where the output format allows it, otherwise use the deepest one it has.
+        auto bitDepths = format->getPossibleBitDepths();
+        auto bitsPerSample = bitDepths.contains(static_cast<int>(reader->bitsPerSample)) ? static_cast<int>(reader->bitsPerSample)
+                                                                                         : bitDepths.getLast();
+
+        std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate,
+                                                                                 static_cast<unsigned int>(numChannels),
+                                                                                 bitsPerSample, {}, 0));
+
+        if (writer == nullptr)
+        {
+            error = "Couldn't create a " + format->getFormatName() + " writer";
+            return false;
+        }
+
+        // The writer owns the stream now.
+        stream.release();
+
+        processor->setPlayConfigDetails(numChannels, numChannels, sampleRate, settings.blockSize);
+        processor->prepareToPlay(sampleRate, settings.blockSize);
+        processor->reset();
+
+        /* Anything that delays the signal is compensated here: the first latency samples of output are dropped
+         * and the same number of samples of silence are fed in after the end of the file.
+         */
+        const auto latency = static_cast<juce::int64>(processor->getLatencySamples());
+        const auto length = reader->lengthInSamples;
+
+        buffer.setSize(numChannels, settings.blockSize, false, false, true);
+
+        for (juce::int64 position = 0; position < length + latency; position += settings.blockSize)
+        {
+            const auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(settings.blockSize), length + latency - position));
+            const auto numToRead = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(numSamples), length - position));
+
+            buffer.clear();
+
+            if (numToRead > 0)
+                reader->read(&buffer, 0, numToRead, position, true, true);
+
+            processor->processBlock(buffer, midi);
+
+            // Skip whatever part of this block still falls inside the latency.
+            const auto skip = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(numSamples), latency - position));
+
+            if (skip < numSamples && ! writer->writeFromAudioSampleBuffer(buffer, skip, numSamples - skip))
+            {
+                error = "Write failed";
+                processor->releaseResources();
+                return false;
+            }
+        }
+
+        processor->releaseResources();
+        statistics.audioSeconds += static_cast<double>(length) / sampleRate;
+
+        return true;
+    }
+
+    const RenderSettings& settings;
+    const juce::Array<RenderJob>& jobs;
+    std::atomic<int>& nextFile;
+
+    juce::AudioFormatManager formatManager;
+    std::unique_ptr<BasicEQAudioProcessor> processor;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+    RenderStatistics statistics;
+};
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: BasicEQRender --preset <preset.json|preset.xml> --output <directory>" << std::endl
+              << "                     [--jobs <n>] [--block-size <n>] [--format <wav|aiff|flac>]" << std::endl
+              << "                     <file or directory>..." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    // The processors need a message manager, even though nothing here has a UI.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList arguments(argc, argv);
+
+    if (! arguments.containsOption("--preset") || ! arguments.containsOption("--output"))
+    {
+        printUsage();
+        return 1;
+    }
+
+    RenderSettings settings;
+    juce::String error;
+
+    settings.preset = loadPreset(arguments.getExistingFileForOption("--preset"), error);
+
+    // A preset naming a parameter that doesn't exist would fail every file, so it's checked once up front.
+    if (error.isEmpty())
+    {
+        BasicEQAudioProcessor processor;
+        applyPreset(processor, settings.preset, error);
+    }
+
+    if (error.isNotEmpty())
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    settings.outputDirectory = arguments.getFileForOption("--output");
+    settings.outputDirectory.createDirectory();
+    settings.outputFormat = arguments.getValueForOption("--format").toLowerCase();
+
+    if (arguments.containsOption("--block-size"))
+        settings.blockSize = juce::jlimit(16, 65536, arguments.getValueForOption("--block-size").getIntValue());
+
+    // Anything left that isn't an option is an input; directories are searched for audio files.
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    juce::Array<RenderJob> jobs;
+
+    // Every output goes in --output, at the input's path relative to the directory it was found in.
+    auto addJob = [&](const juce::File& input, const juce::File& root)
+    {
+        const auto extension = settings.outputFormat.isNotEmpty() ? "." + settings.outputFormat : input.getFileExtension();
+        const auto relativePath = root != juce::File() ? input.getRelativePathFrom(root) : input.getFileName();
+
+        jobs.add({ input, settings.outputDirectory.getChildFile(relativePath).withFileExtension(extension) });
+    };
+
+    for (int i = 0; i < arguments.size(); ++i)
+    {
+        const auto& argument = arguments.arguments.getReference(i);
+
+        // Skip options along with their values.
+        if (argument.isOption())
+        {
+            if (! argument.text.containsChar('='))
+                ++i;
+
+            continue;
+        }
+
+        auto file = argument.resolveAsFile();
+
+        if (file.isDirectory())
+        {
+            for (const auto& child : file.findChildFiles(juce::File::findFiles, true, formatManager.getWildcardForAllFormats()))
+                addJob(child, file);
+        }
+        else
+        {
+            addJob(file, {});
+        }
+    }
+
+    if (jobs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    /* Two inputs can still map to the same output, say a.wav and a.flac rendered with --format, or the same name
+     * given from two places. Two workers would then write the one file at once, so refuse before starting.
+     */
+    std::map<juce::String, const RenderJob*> outputs;
+
+    for (const auto& job : jobs)
+    {
+        const auto inserted = outputs.emplace(job.output.getFullPathName(), &job);
+
+        if (! inserted.second)
+        {
+            std::cerr << job.input.getFullPathName() << " and " << inserted.first->second->input.getFullPathName()
+                      << " would both be rendered to " << job.output.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    // One worker, and so one processor instance, per core unless told otherwise.
+    auto numJobs = arguments.containsOption("--jobs") ? arguments.getValueForOption("--jobs").getIntValue()
+                                                      : juce::SystemStats::getNumCpus();
+    numJobs = juce::jlimit(1, jobs.size(), numJobs);
+
+    std::atomic<int> nextFile { 0 };
+    std::vector<std::unique_ptr<RenderWorker>> workers;
+
+    for (int i = 0; i < numJobs; ++i)
+        workers.push_back(std::make_unique<RenderWorker>(i, settings, jobs, nextFile));
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (auto& worker : workers)
+        worker->startThread();
+
+    for (auto& worker : workers)
+        worker->waitForThreadToExit(-1);
+
+    const auto elapsedSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    RenderStatistics total;
+
+    for (auto& worker : workers)
+    {
+        total.filesRendered += worker->getStatistics().filesRendered;
+        total.filesFailed += worker->getStatistics().filesFailed;
+        total.audioSeconds += worker->getStatistics().audioSeconds;
+    }
+
+    std::cout << "Rendered " << total.filesRendered << " files (" << total.filesFailed << " failed) with "
+              << numJobs << " workers in " << elapsedSeconds << " s" << std::endl
+              << "Throughput:      " << total.filesRendered / juce::jmax(elapsedSeconds, 1.0e-9) << " files/s" << std::endl
+              << "Realtime factor: " << total.audioSeconds / juce::jmax(elapsedSeconds, 1.0e-9) << "x" << std::endl;
+
+    return total.filesFailed == 0 ? 0 : 2;
+}